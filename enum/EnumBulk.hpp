@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <Span.hpp>
+#include <EnumeratorTraits.hpp>
+
+// Load of size bytes at text as an integer. Byte copy plus bit_cast gives the
+// same result in constant evaluation and at run time, where it is one load.
+template <size_t size>
+constexpr uint64_t EnumLoad(const char* text) {
+    std::array<char, size> bytes{};
+    std::copy_n(text, size, bytes.begin());
+    if constexpr (size == 8) {
+        return std::bit_cast<uint64_t>(bytes);
+    } else {
+        return std::bit_cast<uint32_t>(bytes);
+    }
+}
+
+// Two words that, with the length, are the whole name for names of 4 to 16
+// characters. They are read with four overlapping 4-byte loads whose offsets
+// depend on the length arithmetically, so names of mixed lengths cost no
+// branch mispredictions and nothing outside the name is touched. Longer names
+// keep their first and last 8 bytes, shorter ones their bytes.
+struct EnumNameWords {
+    uint64_t head = 0;
+    uint64_t tail = 0;
+
+    static constexpr EnumNameWords Of(std::string_view name) {
+        const char* text = name.data();
+        size_t size = name.size();
+        if (size - 4 <= 12) [[likely]] {
+            size_t middle = (size >> 3) << 2;
+            return {EnumLoad<4>(text) | EnumLoad<4>(text + middle) << 32,
+                    EnumLoad<4>(text + size - 4 - middle) | EnumLoad<4>(text + size - 4) << 32};
+        }
+        if (size > 16) {
+            return {EnumLoad<8>(text), EnumLoad<8>(text + size - 8)};
+        }
+        if (size > 0) {
+            return {uint64_t(uint8_t(text[0])) | uint64_t(uint8_t(text[size / 2])) << 8, uint8_t(text[size - 1])};
+        }
+        return {};
+    }
+
+    // Only needs to tell the names of one enum apart, which EnumBulkTables
+    // checks, since EnumPerfectHash mixes it again.
+    constexpr uint64_t Key(size_t size) const {
+        return (head * 0x9e3779b97f4a7c15ull) ^ std::rotl(tail, 31) ^ size;
+    }
+};
+
+// Tables behind FormatAll and ParseAll, built at compile time from the
+// names of E.
+template <EnumType E, class Traits = EnumeratorTraits<E>>
+struct EnumBulkTables {
+    static constexpr size_t N = Traits::size();
+
+    static constexpr size_t kLongest = [] {
+        size_t longest = 0;
+        for (size_t i = 0; i < N; ++i) {
+            longest = std::max(longest, Traits::nameAt(i).size());
+        }
+        return longest;
+    }();
+
+    // Every name sits zero-padded after its length byte in a record of
+    // kRecord bytes, so formatting copies a fixed kRecord - 1 bytes and then
+    // advances by the length.
+    static constexpr size_t kRecord = std::max<size_t>(16, std::bit_ceil(kLongest + 1));
+
+    static_assert(kLongest <= UINT8_MAX, "enumerator name too long for FormatAll");
+
+    static consteval std::array<std::array<char, kRecord>, N> Records() {
+        std::array<std::array<char, kRecord>, N> records{};
+        for (size_t i = 0; i < N; ++i) {
+            std::string_view name = Traits::nameAt(i);
+            records[i][0] = char(name.size());
+            std::copy(name.begin(), name.end(), records[i].begin() + 1);
+        }
+        return records;
+    }
+
+    struct ParseEntry {
+        EnumNameWords words;
+        size_t length;
+    };
+
+    static consteval std::array<ParseEntry, N> ParseEntries() {
+        std::array<ParseEntry, N> entries{};
+        for (size_t i = 0; i < N; ++i) {
+            entries[i] = {EnumNameWords::Of(Traits::nameAt(i)), Traits::nameAt(i).size()};
+        }
+        return entries;
+    }
+
+    static consteval std::array<uint64_t, N> Keys() {
+        std::array<ParseEntry, N> entries = ParseEntries();
+        std::array<uint64_t, N> keys{};
+        for (size_t i = 0; i < N; ++i) {
+            keys[i] = entries[i].words.Key(entries[i].length);
+        }
+        return keys;
+    }
+
+    // Names longer than 16 characters can share their first and last words;
+    // ParseAll then falls back to Traits::fromName.
+    static constexpr bool kDistinctKeys = [] {
+        std::array<uint64_t, N> keys = Keys();
+        std::sort(keys.begin(), keys.end());
+        return std::adjacent_find(keys.begin(), keys.end()) == keys.end();
+    }();
+
+    static constexpr std::array<std::array<char, kRecord>, N> records = Records();
+    // Written for values that are not enumerators.
+    static constexpr std::array<char, kRecord> empty{};
+    static constexpr std::array<ParseEntry, N> entries = ParseEntries();
+    static constexpr EnumPerfectHash<N> hash = [] {
+        if constexpr (kDistinctKeys) {
+            return EnumPerfectHash<N>::Build(Keys());
+        } else {
+            return EnumPerfectHash<N>{};
+        }
+    }();
+
+    static_assert(hash.perfect, "no perfect hash found for the enumerator names");
+
+    [[gnu::always_inline]] static std::optional<size_t> Find(std::string_view text) {
+        if (text.size() > kLongest) {
+            return std::nullopt;
+        }
+        if constexpr (!kDistinctKeys) {
+            std::optional<E> value = Traits::fromName(text);
+            return value ? Traits::indexOf(*value) : std::nullopt;
+        } else {
+            return FindByWords(text);
+        }
+    }
+
+private:
+    [[gnu::always_inline]] static std::optional<size_t> FindByWords(std::string_view text) {
+        EnumNameWords words = EnumNameWords::Of(text);
+        size_t index = hash.Find(words.Key(text.size()));
+        if (index == N) {
+            return std::nullopt;
+        }
+        const ParseEntry& entry = entries[index];
+        if (entry.length != text.size() || entry.words.head != words.head || entry.words.tail != words.tail) {
+            return std::nullopt;
+        }
+        // Up to 16 characters the words cover the whole name; longer names
+        // compare their middle too.
+        if (kLongest > 16 && text.size() > 16 && std::memcmp(text.data() + 8, records[index].data() + 9, text.size() - 16) != 0) {
+            return std::nullopt;
+        }
+        return index;
+    }
+};
+
+struct EnumFormatResult {
+    // Values written in full, fewer than given if output ran out.
+    size_t values;
+    // Bytes of output used by them.
+    size_t bytes;
+    // Values among them that are not enumerators, written as empty fields.
+    size_t invalid;
+};
+
+// Writes the name of every value followed by separator into output. Each name
+// is copied as a fixed-size record, so the copy compiles to a few vector
+// stores with no branch on the length.
+template <EnumType E, class Traits = EnumeratorTraits<E>>
+EnumFormatResult FormatAll(Span<const E> values, Span<char> output, char separator = '\n') {
+    using Tables = EnumBulkTables<E, Traits>;
+    constexpr size_t kRecord = Tables::kRecord;
+    char* out = output.Data();
+    char* const end = out + output.Size();
+    size_t invalid = 0;
+    size_t i = 0;
+    for (; i < values.Size(); ++i) {
+        std::optional<size_t> index = Traits::indexOf(values[i]);
+        const char* record = index ? Tables::records[*index].data() : Tables::empty.data();
+        size_t length = uint8_t(record[0]);
+        if (size_t(end - out) >= kRecord) [[likely]] {
+            std::memcpy(out, record + 1, kRecord - 1);
+        } else if (size_t(end - out) > length) {
+            std::memcpy(out, record + 1, length);
+        } else {
+            break;
+        }
+        out += length;
+        *out++ = separator;
+        invalid += !index;
+    }
+    return {i, size_t(out - output.Data()), invalid};
+}
+
+// Parses every text as a name of E into values[i], which must have room for
+// all of them. Texts that are not names leave their value as is. Returns how
+// many texts were not names.
+template <EnumType E, class Traits = EnumeratorTraits<E>>
+size_t ParseAll(Span<const std::string_view> texts, Span<E> values) {
+    assert(values.Size() >= texts.Size());
+    size_t invalid = 0;
+    for (size_t i = 0; i < texts.Size(); ++i) {
+        std::optional<size_t> index = EnumBulkTables<E, Traits>::Find(texts[i]);
+        if (index) {
+            values[i] = Traits::at(*index);
+        } else {
+            ++invalid;
+        }
+    }
+    return invalid;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include "EnumeratorTraits.hpp"
+
+// Map with one V for every enumerator of E, stored in an std::array in at(i)
+// order and addressed through Traits::indexOf: no hashing and no allocation.
+template <EnumType E, class V, class Traits = EnumeratorTraits<E>>
+class EnumMap {
+public:
+    using key_type = E;
+    using mapped_type = V;
+
+    template <bool is_const>
+    class Iterator {
+    public:
+        using Reference = std::pair<E, std::conditional_t<is_const, const V&, V&>>;
+        using value_type = Reference;
+        using difference_type = std::ptrdiff_t;
+
+        constexpr Iterator() = default;
+        constexpr Iterator(std::conditional_t<is_const, const EnumMap*, EnumMap*> map, std::size_t index)
+            : map_(map), index_(index) {}
+
+        constexpr Reference operator*() const {
+            return {Traits::at(index_), map_->values_[index_]};
+        }
+        constexpr Iterator& operator++() {
+            ++index_;
+            return *this;
+        }
+        constexpr Iterator operator++(int) {
+            Iterator old = *this;
+            ++index_;
+            return old;
+        }
+        constexpr bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+    private:
+        std::conditional_t<is_const, const EnumMap*, EnumMap*> map_ = nullptr;
+        std::size_t index_ = 0;
+    };
+
+    constexpr EnumMap() = default;
+
+    // Enumerators not listed keep a value-initialized V.
+    constexpr EnumMap(std::initializer_list<std::pair<E, V>> items) {
+        for (const auto& [key, value] : items) {
+            (*this)[key] = value;
+        }
+    }
+
+    static constexpr std::size_t size() noexcept {
+        return Traits::size();
+    }
+
+    // True if key is an enumerator, that is, if the map has a value for it.
+    static constexpr bool contains(E key) noexcept {
+        return Traits::indexOf(key).has_value();
+    }
+
+    // key must be an enumerator.
+    constexpr V& operator[](E key) {
+        std::optional<std::size_t> index = Traits::indexOf(key);
+        assert(index);
+        return values_[*index];
+    }
+    constexpr const V& operator[](E key) const {
+        std::optional<std::size_t> index = Traits::indexOf(key);
+        assert(index);
+        return values_[*index];
+    }
+
+    constexpr V& at(E key) {
+        return values_[IndexOrThrow(key)];
+    }
+    constexpr const V& at(E key) const {
+        return values_[IndexOrThrow(key)];
+    }
+
+    // Values in at(i) order.
+    constexpr std::array<V, Traits::size()>& values() noexcept {
+        return values_;
+    }
+    constexpr const std::array<V, Traits::size()>& values() const noexcept {
+        return values_;
+    }
+
+    constexpr Iterator<false> begin() {
+        return {this, 0};
+    }
+    constexpr Iterator<false> end() {
+        return {this, size()};
+    }
+    constexpr Iterator<true> begin() const {
+        return {this, 0};
+    }
+    constexpr Iterator<true> end() const {
+        return {this, size()};
+    }
+
+    constexpr bool operator==(const EnumMap&) const = default;
+
+private:
+    static constexpr std::size_t IndexOrThrow(E key) {
+        std::optional<std::size_t> index = Traits::indexOf(key);
+        if (!index) {
+            throw std::out_of_range("EnumMap::at: not an enumerator");
+        }
+        return *index;
+    }
+
+    std::array<V, Traits::size()> values_{};
+};
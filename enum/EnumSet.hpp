@@ -0,0 +1,180 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <optional>
+#include "EnumeratorTraits.hpp"
+
+// Set of enumerators of E as a bitset over their at(i) indices. Set algebra
+// works word by word in plain loops the compiler vectorizes; iteration goes
+// in at(i) order.
+template <EnumType E, class Traits = EnumeratorTraits<E>>
+class EnumSet {
+    static constexpr std::size_t kBits = Traits::size();
+    static constexpr std::size_t kWords = (kBits + 63) / 64;
+
+public:
+    using value_type = E;
+
+    class Iterator {
+    public:
+        using value_type = E;
+        using difference_type = std::ptrdiff_t;
+
+        constexpr Iterator() = default;
+        constexpr Iterator(const EnumSet* set, std::size_t index) : set_(set), index_(index) {
+            Skip();
+        }
+
+        constexpr E operator*() const {
+            return Traits::at(index_);
+        }
+        constexpr Iterator& operator++() {
+            ++index_;
+            Skip();
+            return *this;
+        }
+        constexpr Iterator operator++(int) {
+            Iterator old = *this;
+            ++*this;
+            return old;
+        }
+        constexpr bool operator==(const Iterator& other) const {
+            return index_ == other.index_;
+        }
+
+    private:
+        // Moves to the first member at or after index_.
+        constexpr void Skip() {
+            while (index_ < kBits) {
+                uint64_t word = set_->words_[index_ / 64] >> (index_ % 64);
+                if (word != 0) {
+                    index_ += std::countr_zero(word);
+                    return;
+                }
+                index_ = (index_ / 64 + 1) * 64;
+            }
+            index_ = kBits;
+        }
+
+        const EnumSet* set_ = nullptr;
+        std::size_t index_ = kBits;
+    };
+
+    constexpr EnumSet() = default;
+
+    // Values that are not enumerators are ignored.
+    constexpr EnumSet(std::initializer_list<E> items) {
+        for (E item : items) {
+            insert(item);
+        }
+    }
+
+    static constexpr EnumSet All() {
+        EnumSet set;
+        for (std::size_t i = 0; i < kBits; ++i) {
+            set.words_[i / 64] |= uint64_t(1) << (i % 64);
+        }
+        return set;
+    }
+
+    // Returns false if value is not an enumerator.
+    constexpr bool insert(E value) {
+        std::optional<std::size_t> index = Traits::indexOf(value);
+        if (!index) {
+            return false;
+        }
+        words_[*index / 64] |= uint64_t(1) << (*index % 64);
+        return true;
+    }
+
+    constexpr void erase(E value) {
+        if (std::optional<std::size_t> index = Traits::indexOf(value)) {
+            words_[*index / 64] &= ~(uint64_t(1) << (*index % 64));
+        }
+    }
+
+    constexpr bool contains(E value) const {
+        std::optional<std::size_t> index = Traits::indexOf(value);
+        return index && (words_[*index / 64] >> (*index % 64) & 1);
+    }
+
+    constexpr std::size_t size() const {
+        std::size_t count = 0;
+        for (uint64_t word : words_) {
+            count += std::popcount(word);
+        }
+        return count;
+    }
+
+    constexpr bool empty() const {
+        for (uint64_t word : words_) {
+            if (word != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr void clear() {
+        words_ = {};
+    }
+
+    constexpr EnumSet& operator|=(const EnumSet& other) {
+        for (std::size_t i = 0; i < kWords; ++i) {
+            words_[i] |= other.words_[i];
+        }
+        return *this;
+    }
+    constexpr EnumSet& operator&=(const EnumSet& other) {
+        for (std::size_t i = 0; i < kWords; ++i) {
+            words_[i] &= other.words_[i];
+        }
+        return *this;
+    }
+    constexpr EnumSet& operator^=(const EnumSet& other) {
+        for (std::size_t i = 0; i < kWords; ++i) {
+            words_[i] ^= other.words_[i];
+        }
+        return *this;
+    }
+    constexpr EnumSet& operator-=(const EnumSet& other) {
+        for (std::size_t i = 0; i < kWords; ++i) {
+            words_[i] &= ~other.words_[i];
+        }
+        return *this;
+    }
+
+    friend constexpr EnumSet operator|(EnumSet lhs, const EnumSet& rhs) {
+        return lhs |= rhs;
+    }
+    friend constexpr EnumSet operator&(EnumSet lhs, const EnumSet& rhs) {
+        return lhs &= rhs;
+    }
+    friend constexpr EnumSet operator^(EnumSet lhs, const EnumSet& rhs) {
+        return lhs ^= rhs;
+    }
+    friend constexpr EnumSet operator-(EnumSet lhs, const EnumSet& rhs) {
+        return lhs -= rhs;
+    }
+    // Complement within the enumerators of E.
+    constexpr EnumSet operator~() const {
+        return All() - *this;
+    }
+
+    constexpr bool operator==(const EnumSet&) const = default;
+
+    constexpr Iterator begin() const {
+        return {this, 0};
+    }
+    constexpr Iterator end() const {
+        return {this, kBits};
+    }
+
+private:
+    std::array<uint64_t, kWords> words_{};
+};
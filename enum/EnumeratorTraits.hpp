@@ -5,12 +5,14 @@
 #include <type_traits>
 #include <cstdint>
 #include <array>
+#include <bit>
 #include <iostream>
 #include <ranges>
 #include <algorithm>
 #include <string_view>
 #include <optional>
 #include <numeric>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 
@@ -22,84 +24,525 @@ namespace vi = rng::views;
 
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wenum-constexpr-conversion"
-// your code for which the warning gets suppressed 
-template<auto e>
-constexpr std::string_view GetEnumName() {
-    auto name = std::string_view(__PRETTY_FUNCTION__);
-    auto rev = vi::reverse(name);
-    auto a = std::min(rng::find(rev, ')'), rng::find(rev, ':'));
-    auto end = std::min(a, rng::find(rev, ' '));
-    if (*end == ')') {
-        return "";
-    }
-    return std::string_view(end.base(), name.end() - 1);
+
+// Optional customization point: specialize with static constexpr min and max
+// (inclusive) to probe exactly that range of values instead of [-MAXN-1, MAXN].
+//     template <> struct EnumRange<Port> { static constexpr int64_t min = 10000, max = 10100; };
+template <EnumType E>
+struct EnumRange;
+
+template <typename E>
+concept HasEnumRange = requires {
+    { EnumRange<E>::min } -> std::convertible_to<int64_t>;
+    { EnumRange<E>::max } -> std::convertible_to<int64_t>;
+};
+
+// Optional customization point: specialize as std::true_type to reflect E as a
+// set of flags. Only 0 and the single bits of the underlying type are probed,
+// so flags up to 1ull << 63 are found, and toString/parseFlags become available.
+//     template <> struct EnumFlags<Perm> : std::true_type {};
+template <EnumType E>
+struct EnumFlags : std::false_type {};
+
+template <typename E>
+concept FlagEnum = EnumType<E> && EnumFlags<E>::value;
+
+// Values probed by one instantiation of ProbeNames.
+inline constexpr size_t kEnumProbeChunk = 128;
+
+// Names of all probed values, parsed from a single __PRETTY_FUNCTION__ in which
+// the compiler prints the pack as "{A, ns::E::B, (ns::E)2, ...}" (GCC) or
+// "<A, ns::E::B, (ns::E)2, ...>" (Clang): values with no enumerator come out
+// as casts and get an empty name. The cast prefix is the same for all of them,
+// so it is measured once and then skipped; constant evaluation is slow enough
+// for every character looked at to count.
+template<EnumType E, E... values>
+consteval std::array<std::string_view, sizeof...(values)> ProbeNames() {
+    std::string_view text = __PRETTY_FUNCTION__;
+    const char* p = text.data() + text.find("values = ") + 9;
+    const char close = *p == '{' ? '}' : '>';
+    size_t cast_length = 0;
+    std::array<std::string_view, sizeof...(values)> names{};
+    for (std::string_view& name : names) {
+        ++p;
+        while (*p == ' ') {
+            ++p;
+        }
+        if (*p == '(') {
+            if (cast_length == 0) {
+                int depth = 0;
+                do {
+                    depth += (p[cast_length] == '(') - (p[cast_length] == ')');
+                    ++cast_length;
+                } while (depth > 0);
+            }
+            p += cast_length;
+            while (*p != ',' && *p != close) {
+                ++p;
+            }
+            continue;
+        }
+        const char* begin = p;
+        int depth = 0;
+        for (; depth > 0 || (*p != ',' && *p != close); ++p) {
+            if (*p == ':' && depth == 0) {
+                begin = p + 1;
+            }
+            depth += (*p == '<' || *p == '(') - (*p == '>' || *p == ')');
+        }
+        name = std::string_view(begin, p - begin);
+    }
+    return names;
 }
 
-template<auto e>
-constexpr static auto enumName = GetEnumName<e>();
+template<EnumType E, int64_t first, int64_t... offsets>
+consteval auto ProbeChunk(std::integer_sequence<int64_t, offsets...>) {
+    return ProbeNames<E, static_cast<E>(first + offsets)...>();
+}
 
+// Reflects the enumerators of E with values in [min, max], kEnumProbeChunk
+// values per instantiation, in value order.
+template<EnumType E, int64_t min, int64_t max>
+struct EnumProbe {
+    static constexpr size_t kCount = size_t(max - min + 1);
+    static constexpr size_t kChunks = (kCount + kEnumProbeChunk - 1) / kEnumProbeChunk;
 
+    static consteval size_t ChunkSize(size_t chunk) {
+        return std::min(kEnumProbeChunk, kCount - chunk * kEnumProbeChunk);
+    }
+
+    template<size_t... chunk>
+    static consteval std::array<std::string_view, kCount> Probe(std::index_sequence<chunk...>) {
+        std::array<std::string_view, kCount> names{};
+        auto store = [&names](size_t offset, const auto& part) {
+            rng::copy(part, names.begin() + offset);
+        };
+        (store(chunk * kEnumProbeChunk,
+               ProbeChunk<E, min + int64_t(chunk * kEnumProbeChunk)>(
+                   std::make_integer_sequence<int64_t, ChunkSize(chunk)>{})), ...);
+        return names;
+    }
 
-template<EnumType E, typename Positive>
-struct HelperBig;
+    static constexpr std::array<std::string_view, kCount> probed = Probe(std::make_index_sequence<kChunks>{});
 
-template<EnumType E, int... pos>
-struct HelperBig<E, std::integer_sequence<int, pos...>> {
-    constexpr static bool is_signed = std::is_signed_v<std::underlying_type_t<E>>;
+    static constexpr size_t size = rng::count_if(probed, [](std::string_view name) { return !name.empty(); });
 
-    template<int val>
-    static consteval auto Get() {
-        return enumName<static_cast<E>(val)>;
+    static consteval auto Collect() {
+        std::array<std::pair<std::string_view, E>, size> result{};
+        size_t count = 0;
+        for (size_t i = 0; i < kCount; ++i) {
+            if (!probed[i].empty()) {
+                result[count++] = {probed[i], static_cast<E>(min + int64_t(i))};
+            }
+        }
+        return result;
     }
 
-    template<int val>
-    static consteval auto IsOk() {
-        return !Get<val>().empty();
+    static constexpr auto at_array = Collect();
+};
+
+// Reflects the enumerators of a flag enum E with value 0 or a single bit, in
+// value order.
+template<EnumType E>
+struct EnumFlagProbe {
+    using Bits = std::make_unsigned_t<std::underlying_type_t<E>>;
+    static constexpr size_t kBits = std::numeric_limits<Bits>::digits;
+    static constexpr bool kSigned = std::is_signed_v<std::underlying_type_t<E>>;
+    static constexpr size_t kCount = kBits + 1;
+
+    // Probed in value order: the sign bit first if it makes the value negative,
+    // then 0, then the other bits from the lowest.
+    static constexpr std::array<Bits, kCount> kValues = [] {
+        std::array<Bits, kCount> values{};
+        for (size_t bit = 0; bit < kBits; ++bit) {
+            values[kSigned ? (bit + 2) % kCount : bit + 1] = Bits(Bits(1) << bit);
+        }
+        return values;
+    }();
+
+    // Copied rather than returned straight from ProbeNames, which GCC 12 then
+    // fails to evaluate as the initializer of probed.
+    template<size_t... i>
+    static consteval std::array<std::string_view, kCount> Probe(std::index_sequence<i...>) {
+        std::array<std::string_view, kCount> names{};
+        rng::copy(ProbeNames<E, static_cast<E>(kValues[i])...>(), names.begin());
+        return names;
     }
 
-    static consteval size_t SizePos() {
-        return (0 + ... + size_t(IsOk<pos>()));
+    static constexpr std::array<std::string_view, kCount> probed = Probe(std::make_index_sequence<kCount>{});
+
+    static constexpr size_t size = rng::count_if(probed, [](std::string_view name) { return !name.empty(); });
+
+    static consteval auto Collect() {
+        std::array<std::pair<std::string_view, E>, size> result{};
+        size_t count = 0;
+        for (size_t i = 0; i < kCount; ++i) {
+            if (!probed[i].empty()) {
+                result[count++] = {probed[i], static_cast<E>(kValues[i])};
+            }
+        }
+        return result;
     }
 
-    static consteval size_t SizeNeg() {
-        if constexpr(is_signed) {
-            return (0 + ... + size_t(IsOk<-pos - 1>()));
-        } else {
-            return 0;
+    // Index + 1 in at_array of the enumerator of each bit, 0 if none; the last
+    // entry is for the value 0.
+    static consteval std::array<uint8_t, kBits + 1> BitIndices() {
+        std::array<uint8_t, kBits + 1> indices{};
+        size_t count = 0;
+        for (size_t i = 0; i < kCount; ++i) {
+            if (!probed[i].empty()) {
+                indices[kValues[i] == 0 ? kBits : std::countr_zero(kValues[i])] = uint8_t(++count);
+            }
         }
+        return indices;
     }
 
-    constexpr static auto pos_size = SizePos();
-    constexpr static auto neg_size = SizeNeg();
+    static constexpr auto at_array = Collect();
+    static constexpr std::array<uint8_t, kBits + 1> bit_indices = BitIndices();
+};
 
-    static consteval size_t Size() {
-        return pos_size + neg_size;
+constexpr uint64_t EnumNameHash(std::string_view name) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : name) {
+        hash = (hash ^ uint8_t(c)) * 0x100000001b3ull;
     }
+    return hash;
+}
+
+constexpr uint64_t EnumMix(uint64_t key, uint64_t seed) {
+    key = (key ^ seed * 0x9e3779b97f4a7c15ull) * 0xff51afd7ed558ccdull;
+    return key ^ (key >> 31);
+}
+
+// Hash-and-displace perfect hash over N distinct 64-bit keys, built at compile
+// time: a key picks a bucket, and the bucket's seed sends it to a slot of its
+// own. Find returns the index of the only key that can match, or N.
+template <size_t N>
+struct EnumPerfectHash {
+    static constexpr size_t kSlots = std::bit_ceil(2 * N + 1);
+    static constexpr size_t kBuckets = std::bit_ceil(N / 2 + 1);
+    static constexpr uint32_t kMaxSeed = UINT16_MAX;
 
+    std::array<uint16_t, kBuckets> seeds{};
+    // Index + 1 of the key in each slot, 0 when empty.
+    std::array<uint16_t, kSlots> slots{};
+    bool perfect = true;
 
-    template<int value>
-    static consteval void helper(auto& neg_iter, auto& pos_iter) {
-        if constexpr (IsOk<value>()) {
-            *pos_iter = std::make_pair(Get<value>(), value);
-            ++pos_iter;
+    constexpr size_t Find(uint64_t key) const {
+        uint64_t mixed = EnumMix(key, 0);
+        size_t slot = EnumMix(mixed, seeds[mixed & (kBuckets - 1)]) & (kSlots - 1);
+        return slots[slot] == 0 ? N : slots[slot] - 1;
+    }
+
+    static consteval EnumPerfectHash Build(const std::array<uint64_t, N>& keys) {
+        EnumPerfectHash table;
+        std::array<uint64_t, N> mixed{};
+        std::array<size_t, kBuckets + 1> starts{};
+        for (size_t i = 0; i < N; ++i) {
+            mixed[i] = EnumMix(keys[i], 0);
+            ++starts[(mixed[i] & (kBuckets - 1)) + 1];
+        }
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            starts[bucket + 1] += starts[bucket];
+        }
+        // Keys grouped by bucket: bucket b holds members[starts[b], starts[b + 1]).
+        std::array<size_t, N> members{};
+        std::array<size_t, kBuckets> filled{};
+        for (size_t i = 0; i < N; ++i) {
+            size_t bucket = mixed[i] & (kBuckets - 1);
+            members[starts[bucket] + filled[bucket]++] = i;
         }
-        if constexpr(is_signed && IsOk<- value - 1>()) {
-            --neg_iter;
-            *neg_iter = std::make_pair(Get<- value - 1>(), - value - 1);
+        std::array<size_t, kBuckets> order{};
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(), [&filled](size_t a, size_t b) {
+            return filled[a] != filled[b] ? filled[a] > filled[b] : a < b;
+        });
+        for (size_t bucket : order) {
+            if (filled[bucket] == 0) {
+                break;
+            }
+            if (!table.Place(bucket, mixed, members.data() + starts[bucket], filled[bucket])) {
+                table.perfect = false;
+                return table;
+            }
         }
+        return table;
     }
 
-    static consteval auto Good() {
-        std::array<std::pair<std::string_view, int>, Size()> result;
-        auto pos_iter = result.begin() + neg_size;
-        auto neg_iter = result.begin() + neg_size;
-        
-        (... , helper<pos>(neg_iter, pos_iter));
-        return result;
+private:
+    consteval bool Place(size_t bucket, const std::array<uint64_t, N>& mixed, const size_t* members, size_t count) {
+        for (uint32_t seed = 1; seed <= kMaxSeed; ++seed) {
+            std::array<size_t, N> taken{};
+            bool free = true;
+            for (size_t i = 0; i < count && free; ++i) {
+                taken[i] = EnumMix(mixed[members[i]], seed) & (kSlots - 1);
+                free = slots[taken[i]] == 0 && std::find(taken.begin(), taken.begin() + i, taken[i]) == taken.begin() + i;
+            }
+            if (!free) {
+                continue;
+            }
+            seeds[bucket] = uint16_t(seed);
+            for (size_t i = 0; i < count; ++i) {
+                slots[taken[i]] = uint16_t(members[i] + 1);
+            }
+            return true;
+        }
+        return false;
+    }
+};
+
+// Smallest unsigned type that holds max.
+template <uint64_t max>
+using EnumUint = std::conditional_t<max <= UINT8_MAX, uint8_t,
+                 std::conditional_t<max <= UINT16_MAX, uint16_t,
+                 std::conditional_t<max <= UINT32_MAX, uint32_t, uint64_t>>>;
+
+// What is kept at run time of the enumerators reflected in Probe. Probe's own
+// at_array points its names into the __PRETTY_FUNCTION__ of every probe
+// instantiation and takes 24 bytes per enumerator, so it is only read during
+// constant evaluation. Instead, the names are copied into one blob, in at(i)
+// order, with a name that starts or ends another one stored only there; each
+// enumerator keeps a 16-bit offset and length into it. Values are stored as
+// their distance from the smallest one, in the narrowest type that fits.
+template <EnumType E, class Probe>
+struct EnumStorage {
+    static constexpr size_t N = Probe::size;
+
+    // Offsets are computed modulo 2^64, which is exact for signed and
+    // unsigned types alike, up to flags at 1ull << 63.
+    static constexpr uint64_t kFirst = N == 0 ? 0 : uint64_t(Probe::at_array.front().second);
+    static constexpr uint64_t kRange = N == 0 ? 0 : uint64_t(Probe::at_array.back().second) - kFirst + 1;
+
+    using Offset = EnumUint<kRange == 0 ? 0 : kRange - 1>;
+
+    struct NameRef {
+        uint16_t offset;
+        uint16_t length;
+    };
+
+    struct Layout {
+        std::array<NameRef, N> names{};
+        size_t size = 0;
+    };
+
+    static consteval std::array<uint64_t, N> NameKeys() {
+        std::array<uint64_t, N> keys{};
+        for (size_t i = 0; i < N; ++i) {
+            keys[i] = EnumNameHash(Probe::at_array[i].first);
+        }
+        return keys;
+    }
+
+    // Perfect hash of the names, shared with EnumLookup.
+    static constexpr auto name_hash = EnumPerfectHash<N>::Build(NameKeys());
+
+    // container[i]: index + 1 of the longest name that starts or ends with name
+    // i. Prefixes and suffixes are looked up in name_hash, but only those with
+    // the length and last (or first) character of some name: lookups are slow
+    // enough in constant evaluation for a hash per prefix to add up.
+    static consteval std::array<size_t, N> Containers() {
+        std::array<size_t, N> container{};
+        size_t longest = 0;
+        for (const auto& [name, value] : Probe::at_array) {
+            longest = std::max(longest, name.size());
+        }
+        std::vector<bool> starts((longest + 1) * 256), ends((longest + 1) * 256);
+        for (const auto& [name, value] : Probe::at_array) {
+            if (!name.empty()) {
+                starts[name.size() * 256 + uint8_t(name.front())] = true;
+                ends[name.size() * 256 + uint8_t(name.back())] = true;
+            }
+        }
+        auto claim = [&container](std::string_view part, uint64_t key, size_t outer) {
+            size_t i = name_hash.Find(key);
+            if (i != N && Probe::at_array[i].first == part &&
+                (container[i] == 0 || Probe::at_array[container[i] - 1].first.size() < Probe::at_array[outer].first.size())) {
+                container[i] = outer + 1;
+            }
+        };
+        for (size_t j = 0; j < N; ++j) {
+            std::string_view outer = Probe::at_array[j].first;
+            uint64_t prefix = EnumNameHash({});
+            for (size_t length = 1; length < outer.size(); ++length) {
+                prefix = (prefix ^ uint8_t(outer[length - 1])) * 0x100000001b3ull;
+                if (ends[length * 256 + uint8_t(outer[length - 1])]) {
+                    claim(outer.substr(0, length), prefix, j);
+                }
+                std::string_view suffix = outer.substr(outer.size() - length);
+                if (starts[length * 256 + uint8_t(suffix.front())]) {
+                    claim(suffix, EnumNameHash(suffix), j);
+                }
+            }
+        }
+        return container;
+    }
+
+    static consteval Layout Place() {
+        Layout layout;
+        std::array<size_t, N> container = Containers();
+        for (size_t i = 0; i < N; ++i) {
+            if (container[i] == 0) {
+                layout.names[i] = {uint16_t(layout.size), uint16_t(Probe::at_array[i].first.size())};
+                layout.size += Probe::at_array[i].first.size();
+            }
+        }
+        for (size_t i = 0; i < N; ++i) {
+            size_t root = i;
+            while (container[root] != 0) {
+                root = container[root] - 1;
+            }
+            if (root != i) {
+                layout.names[i] = {uint16_t(layout.names[root].offset + Probe::at_array[root].first.find(Probe::at_array[i].first)),
+                                   uint16_t(Probe::at_array[i].first.size())};
+            }
+        }
+        return layout;
+    }
+
+    static constexpr Layout kLayout = Place();
+
+    static_assert(kLayout.size <= UINT16_MAX, "enumerator names too long");
+
+    static consteval std::array<char, kLayout.size> Blob() {
+        std::array<char, kLayout.size> blob{};
+        for (size_t i = 0; i < N; ++i) {
+            rng::copy(Probe::at_array[i].first, blob.begin() + kLayout.names[i].offset);
+        }
+        return blob;
+    }
+
+    static consteval std::array<Offset, N> Values() {
+        std::array<Offset, N> values{};
+        for (size_t i = 0; i < N; ++i) {
+            values[i] = Offset(uint64_t(Probe::at_array[i].second) - kFirst);
+        }
+        return values;
+    }
+
+    static constexpr std::array<char, kLayout.size> blob = Blob();
+    static constexpr std::array<NameRef, N> names = kLayout.names;
+    static constexpr std::array<Offset, N> values = Values();
+
+    static constexpr E Value(size_t i) {
+        return static_cast<E>(kFirst + values[i]);
+    }
+
+    static constexpr std::string_view Name(size_t i) {
+        return std::string_view(blob.data() + names[i].offset, names[i].length);
     }
-    static constexpr auto at_array = Good();
 };
 
+// Value and name lookups for the enumerators reflected in Probe.
+template <EnumType E, class Probe>
+struct EnumLookup {
+    using Storage = EnumStorage<E, Probe>;
+
+    static constexpr size_t N = Probe::size;
+
+    static constexpr uint64_t kFirst = Storage::kFirst;
+    static constexpr uint64_t kRange = Storage::kRange;
+    // Ranges up to this size are indexed directly by value.
+    static constexpr bool kDense = kRange <= 8 * N + 64;
+
+    using Index = EnumUint<N + 1>;
+
+    static consteval auto DenseTable() {
+        std::array<Index, kDense ? kRange : 0> table{};
+        if constexpr (kDense) {
+            for (size_t i = 0; i < N; ++i) {
+                table[Storage::values[i]] = Index(i + 1);
+            }
+        }
+        return table;
+    }
+
+    static consteval std::array<uint64_t, N> ValueKeys() {
+        std::array<uint64_t, N> keys{};
+        for (size_t i = 0; i < N; ++i) {
+            keys[i] = uint64_t(Probe::at_array[i].second);
+        }
+        return keys;
+    }
+
+    static constexpr auto dense = DenseTable();
+    static constexpr auto values = kDense ? EnumPerfectHash<N>{} : EnumPerfectHash<N>::Build(ValueKeys());
+    static constexpr const auto& names = Storage::name_hash;
+
+    static_assert(N < UINT16_MAX, "too many enumerators");
+    static_assert(values.perfect && names.perfect, "no perfect hash found for the enumerators");
+
+    static constexpr std::optional<size_t> IndexOf(E value) {
+        if constexpr (kDense) {
+            uint64_t offset = uint64_t(value) - kFirst;
+            if (offset >= kRange || dense[offset] == 0) {
+                return std::nullopt;
+            }
+            return dense[offset] - 1;
+        } else {
+            size_t index = values.Find(uint64_t(value));
+            if (index == N || Storage::Value(index) != value) {
+                return std::nullopt;
+            }
+            return index;
+        }
+    }
+
+    static constexpr std::optional<size_t> IndexOf(std::string_view name) {
+        size_t index = names.Find(EnumNameHash(name));
+        if (index == N || Storage::Name(index) != name) {
+            return std::nullopt;
+        }
+        return index;
+    }
+};
+
+// Table of one function per combination of the enumerators reflected by
+// Traits...: entry i calls f with an std::integral_constant for every
+// enumerator, picked by the digits of i in mixed radix (the last Traits
+// varying fastest). Every entry must return the same type, as for std::visit.
+template <class F, class... Traits>
+struct EnumVisitor {
+    static constexpr std::array<size_t, sizeof...(Traits)> kSizes = {Traits::size()...};
+    static constexpr size_t kCount = (Traits::size() * ... * size_t(1));
+
+    static_assert(kCount > 0, "cannot visit an enum without enumerators");
+
+    template <size_t flat, size_t k>
+    static constexpr size_t Digit() {
+        size_t stride = 1;
+        for (size_t j = k + 1; j < sizeof...(Traits); ++j) {
+            stride *= kSizes[j];
+        }
+        return flat / stride % kSizes[k];
+    }
+
+    template <size_t flat, size_t... k>
+    static constexpr decltype(auto) Call(F&& f, std::index_sequence<k...>) {
+        return std::forward<F>(f)(
+            std::integral_constant<std::remove_cv_t<decltype(Traits::at(0))>, Traits::at(Digit<flat, k>())>{}...);
+    }
+
+    using Result = decltype(Call<0>(std::declval<F>(), std::index_sequence_for<Traits...>{}));
+    using Entry = Result (*)(F&&);
+
+    template <size_t flat>
+    static constexpr Result Thunk(F&& f) {
+        static_assert(std::is_same_v<decltype(Call<flat>(std::forward<F>(f), std::index_sequence_for<Traits...>{})), Result>,
+                      "visitor must return the same type for every enumerator");
+        return Call<flat>(std::forward<F>(f), std::index_sequence_for<Traits...>{});
+    }
+
+    [[noreturn]] static Result Invalid(F&&) {
+        throw std::out_of_range("visit: not an enumerator");
+    }
+
+    template <size_t... flat>
+    static consteval std::array<Entry, kCount> Table(std::index_sequence<flat...>) {
+        return {&Thunk<flat>...};
+    }
+
+    static constexpr std::array<Entry, kCount> table = Table(std::make_index_sequence<kCount>{});
+};
 
 template <class Enum, std::size_t MAXN = 512>
 	requires std::is_enum_v<Enum>
@@ -111,18 +554,219 @@ struct EnumeratorTraits {
         return std::min(int64_t(limit), int64_t(MAXN));
     }
 
-    constexpr static int64_t MaxNum = CropPos();
-    using dia = std::make_integer_sequence<int, MaxNum + 1>;
-    using Base = HelperBig<Enum, dia>;
+    consteval static int64_t MinValue() {
+        if constexpr (HasEnumRange<Enum>) {
+            return EnumRange<Enum>::min;
+        } else if constexpr (std::is_signed_v<underlying>) {
+            return -CropPos() - 1;
+        } else {
+            return 0;
+        }
+    }
+
+    consteval static int64_t MaxValue() {
+        if constexpr (HasEnumRange<Enum>) {
+            return EnumRange<Enum>::max;
+        } else {
+            return CropPos();
+        }
+    }
+
+    constexpr static int64_t MaxNum = MaxValue();
+    constexpr static int64_t MinNum = MinValue();
+    using Base = std::conditional_t<FlagEnum<Enum>, EnumFlagProbe<Enum>, EnumProbe<Enum, MinNum, MaxNum>>;
     static constexpr std::size_t size() noexcept {
-        return Base::Size();
+        return Base::size;
     }
     static constexpr Enum at(std::size_t i) noexcept {
-        return static_cast<Enum>(Base::at_array[i].second);
+        return Lookup::Storage::Value(i);
     }
     static constexpr std::string_view nameAt(std::size_t i) noexcept {
-        return Base::at_array[i].first;
+        return Lookup::Storage::Name(i);
+    }
+
+    // Index i with at(i) == value; std::nullopt if value is not an enumerator.
+    // One table load when the values are dense, a perfect hash otherwise.
+    static constexpr std::optional<std::size_t> indexOf(Enum value) noexcept {
+        return Lookup::IndexOf(value);
+    }
+    // Empty if value is not an enumerator.
+    static constexpr std::string_view nameOf(Enum value) noexcept {
+        std::optional<std::size_t> index = indexOf(value);
+        return index ? nameAt(*index) : std::string_view();
+    }
+    static constexpr std::optional<Enum> fromName(std::string_view name) noexcept {
+        std::optional<std::size_t> index = Lookup::IndexOf(name);
+        return index ? std::optional<Enum>(at(*index)) : std::nullopt;
+    }
+
+    // Flag enums only. Room for the longest text toString can produce.
+    static constexpr std::size_t kMaxFlagsLength = [] {
+        std::size_t length = 2 + 16 + 1;  // "0x" and the unnamed bits in hex
+        for (const auto& [name, value] : Base::at_array) {
+            length += name.size() + 1;
+        }
+        return length;
+    }();
+
+    // Flag enums only. Writes the names of the flags set in combo, ascending
+    // and separated by '|', into buffer, with the bits that have no name last
+    // as one hex number; 0 is written as the name of the 0 enumerator or "0".
+    // Returns the length of the whole text and, like snprintf, writes no more
+    // than capacity characters of it. Nothing is allocated or terminated.
+    static constexpr std::size_t toString(Enum combo, char* buffer, std::size_t capacity) noexcept
+        requires FlagEnum<Enum>
+    {
+        using Bits = typename Base::Bits;
+        Bits bits = Bits(combo);
+        std::size_t length = 0;
+        // Names are short, so a plain loop beats a call to memcpy.
+        auto append = [&](std::string_view text) {
+            for (char c : text) {
+                if (length < capacity) {
+                    buffer[length] = c;
+                }
+                ++length;
+            }
+        };
+        if (bits == 0) {
+            uint8_t zero = Base::bit_indices[Base::kBits];
+            append(zero == 0 ? std::string_view("0") : nameAt(zero - 1));
+            return length;
+        }
+        Bits unnamed = 0;
+        for (Bits rest = bits; rest != 0; rest &= rest - 1) {
+            uint8_t index = Base::bit_indices[std::countr_zero(rest)];
+            if (index == 0) {
+                unnamed |= rest & -rest;
+                continue;
+            }
+            if (length != 0) {
+                append("|");
+            }
+            append(nameAt(index - 1));
+        }
+        if (unnamed != 0) {
+            char hex[2 + 16];
+            std::size_t digits = (std::bit_width(unnamed) + 3) / 4;
+            hex[0] = '0';
+            hex[1] = 'x';
+            for (std::size_t i = 0; i < digits; ++i) {
+                hex[1 + digits - i] = "0123456789abcdef"[(unnamed >> (4 * i)) & 0xf];
+            }
+            if (length != 0) {
+                append("|");
+            }
+            append(std::string_view(hex, 2 + digits));
+        }
+        return length;
+    }
+
+    // Flag enums only. Inverse of toString: names and hex numbers separated by
+    // '|', with optional spaces around them. std::nullopt if any part is neither.
+    static constexpr std::optional<Enum> parseFlags(std::string_view text) noexcept
+        requires FlagEnum<Enum>
+    {
+        using Bits = typename Base::Bits;
+        Bits bits = 0;
+        while (true) {
+            std::size_t end = std::min(text.find('|'), text.size());
+            std::string_view part = text.substr(0, end);
+            part.remove_prefix(std::min(part.find_first_not_of(' '), part.size()));
+            part.remove_suffix(part.size() - std::min(part.find_last_not_of(' ') + 1, part.size()));
+            if (std::optional<std::size_t> index = Lookup::IndexOf(part)) {
+                bits |= Bits(at(*index));
+            } else if (std::optional<Bits> number = ParseNumber<Bits>(part)) {
+                bits |= *number;
+            } else {
+                return std::nullopt;
+            }
+            if (end == text.size()) {
+                return static_cast<Enum>(bits);
+            }
+            text.remove_prefix(end + 1);
+        }
+    }
+
+    // Calls f(std::integral_constant<Enum, value>{}), like a switch over the
+    // enumerators with one case each: for dense enums the value indexes a
+    // table of functions directly, holes included; otherwise indexOf picks the
+    // entry. Throws std::out_of_range if value is not an enumerator.
+    template <class F>
+    static constexpr decltype(auto) visit(Enum value, F&& f) {
+        using Visitor = EnumVisitor<F, EnumeratorTraits>;
+        if constexpr (Lookup::kDense) {
+            uint64_t offset = uint64_t(value) - Lookup::kFirst;
+            if (offset >= Lookup::kRange) {
+                return Visitor::Invalid(std::forward<F>(f));
+            }
+            return kDenseVisit<F>[offset](std::forward<F>(f));
+        } else {
+            std::optional<std::size_t> index = indexOf(value);
+            if (!index) {
+                return Visitor::Invalid(std::forward<F>(f));
+            }
+            return Visitor::table[*index](std::forward<F>(f));
+        }
+    }
+
+private:
+    using Lookup = EnumLookup<Enum, Base>;
+
+    template <class F>
+    static constexpr auto kDenseVisit = [] {
+        using Visitor = EnumVisitor<F, EnumeratorTraits>;
+        std::array<typename Visitor::Entry, Lookup::kRange> table{};
+        for (std::size_t offset = 0; offset < Lookup::kRange; ++offset) {
+            std::size_t index = Lookup::dense[offset];
+            table[offset] = index == 0 ? &Visitor::Invalid : Visitor::table[index - 1];
+        }
+        return table;
+    }();
+
+    // "0", or "0x" followed by at most as many hex digits as the type holds.
+    template <class Bits>
+    static constexpr std::optional<Bits> ParseNumber(std::string_view text) noexcept {
+        if (text == "0") {
+            return Bits(0);
+        }
+        if (text.size() < 3 || text.size() > 2 + sizeof(Bits) * 2 || text[0] != '0' || (text[1] != 'x' && text[1] != 'X')) {
+            return std::nullopt;
+        }
+        Bits value = 0;
+        for (char c : text.substr(2)) {
+            int digit = c >= '0' && c <= '9' ? c - '0'
+                      : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                      : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                      : -1;
+            if (digit < 0) {
+                return std::nullopt;
+            }
+            value = Bits(value << 4 | Bits(digit));
+        }
+        return value;
     }
 };
 
-#pragma clang diagnostic pop
\ No newline at end of file
+// Calls f with an std::integral_constant for each of values, through one table
+// over the cross product of their enumerators, so runtime settings can pick a
+// fully specialized kernel:
+//     VisitEnums([](auto layout, auto precision) { Kernel<layout(), precision()>(); }, layout, precision);
+// Throws std::out_of_range if any value is not an enumerator.
+template <class F, EnumType... Es>
+constexpr decltype(auto) VisitEnums(F&& f, Es... values) {
+    using Visitor = EnumVisitor<F, EnumeratorTraits<Es>...>;
+    std::size_t flat = 0;
+    bool valid = true;
+    auto add = [&flat, &valid](std::size_t size, std::optional<std::size_t> index) {
+        valid = valid && index.has_value();
+        flat = flat * size + index.value_or(0);
+    };
+    (add(EnumeratorTraits<Es>::size(), EnumeratorTraits<Es>::indexOf(values)), ...);
+    if (!valid) {
+        return Visitor::Invalid(std::forward<F>(f));
+    }
+    return Visitor::table[flat](std::forward<F>(f));
+}
+
+#pragma clang diagnostic pop
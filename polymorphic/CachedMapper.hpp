@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <typeinfo>
+#include <utility>
+#include <PolymorphicMapper.hpp>
+
+struct MapperCacheStats {
+  size_t hits;
+  size_t misses;
+};
+
+// Memoizes Mapper::map per dynamic type of the argument.
+// Slots are claimed with a CAS and published with a release store, so the hit
+// path is a hash, an acquire load and a compare; no locks are ever taken.
+// The table never grows: once it is full, misses fall through to Mapper::map.
+template <class Mapper, size_t Capacity = 64>
+struct CachedMapper;
+
+template <class Base, class Target, class Mappings, size_t Capacity>
+requires (Capacity != 0 && (Capacity & (Capacity - 1)) == 0)
+struct CachedMapper<PolymorphicMapperOrdered<Base, Target, Mappings>, Capacity> {
+  using Mapper = PolymorphicMapperOrdered<Base, Target, Mappings>;
+  using Result = decltype(Mapper::map(std::declval<const Base&>()));
+
+  static Result map(const Base& object) {
+    const std::type_info& info = typeid(object);
+    const size_t hash = info.hash_code();
+    for (size_t probe = 0; probe < Capacity; ++probe) {
+      Slot& slot = table_.slots[(hash + probe) & (Capacity - 1)];
+      auto state = slot.state.load(std::memory_order_acquire);
+      if (state == kReady) {
+        if (slot.hash == hash && (slot.key == &info || *slot.key == info)) {
+          table_.hits.fetch_add(1, std::memory_order_relaxed);
+          return slot.value;
+        }
+        continue;
+      }
+      table_.misses.fetch_add(1, std::memory_order_relaxed);
+      Result result = Mapper::map(object);
+      if (state == kEmpty && slot.state.compare_exchange_strong(state, kBusy, std::memory_order_relaxed)) {
+        slot.key = &info;
+        slot.hash = hash;
+        slot.value = result;
+        slot.state.store(kReady, std::memory_order_release);
+      }
+      return result;
+    }
+    table_.misses.fetch_add(1, std::memory_order_relaxed);
+    return Mapper::map(object);
+  }
+
+  static MapperCacheStats Stats() {
+    return {table_.hits.load(std::memory_order_relaxed), table_.misses.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  static constexpr uint8_t kEmpty = 0;
+  static constexpr uint8_t kBusy = 1;
+  static constexpr uint8_t kReady = 2;
+
+  struct Slot {
+    std::atomic<uint8_t> state{kEmpty};
+    size_t hash = 0;
+    const std::type_info* key = nullptr;
+    Result value;
+  };
+
+  struct Table {
+    Slot slots[Capacity];
+    alignas(64) std::atomic<size_t> hits{0};
+    alignas(64) std::atomic<size_t> misses{0};
+  };
+
+  static inline Table table_;
+};
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <PolymorphicMapper.hpp>
+
+// Opt-in RTTI-free hierarchy: the root lists every class of the hierarchy,
+// and every constructor along the chain stamps the object with the index of its
+// class in that list, the same way constructors update the vptr. Copies and
+// moves are stamped with the class being constructed, so slicing a Kitten into
+// an Animal yields an Animal; assignment keeps the target's class, as it keeps
+// the target's vptr.
+//
+//   struct Cat; struct Dog;
+//   struct Animal : ClosedRoot<Animal, TTuple<Animal, Cat, Dog>> { ... };
+//   struct Cat : ClosedDerived<Cat, Animal> { ... };
+class ClosedObject {
+ public:
+  size_t ClosedTypeId() const {
+    return closed_type_id_;
+  }
+
+ protected:
+  explicit ClosedObject(uint32_t id) : closed_type_id_(id) {}
+  ClosedObject(const ClosedObject&) = delete;
+  ClosedObject& operator=(const ClosedObject&) {
+    return *this;
+  }
+
+  uint32_t closed_type_id_;
+};
+
+namespace detail {
+
+template <class T, class... Ts>
+consteval size_t IndexIn(TTuple<Ts...>) {
+  size_t index = 0;
+  [[maybe_unused]] bool found = (false || ... || (std::same_as<T, Ts> || (++index, false)));
+  return index;
+}
+
+template <class T, TypeTuple TT>
+constexpr size_t IndexOf = IndexIn<T>(TT{});
+
+}  // namespace detail
+
+template <class Self, UniqueTuple Classes>
+class ClosedRoot : public ClosedObject {
+ public:
+  using ClosedClasses = Classes;
+
+ protected:
+  ClosedRoot() : ClosedObject(detail::IndexOf<Self, Classes>) {}
+  ClosedRoot(const ClosedRoot&) noexcept : ClosedObject(detail::IndexOf<Self, Classes>) {}
+  ClosedRoot(ClosedRoot&&) noexcept : ClosedObject(detail::IndexOf<Self, Classes>) {}
+  ClosedRoot& operator=(const ClosedRoot&) = default;
+  ClosedRoot& operator=(ClosedRoot&&) = default;
+};
+
+template <class Self, class Parent>
+class ClosedDerived : public Parent {
+  static constexpr size_t kId = detail::IndexOf<Self, typename Parent::ClosedClasses>;
+
+  static_assert(kId < detail::SizeOf<typename Parent::ClosedClasses>, "class is missing from the ClosedRoot class list");
+
+ protected:
+  template <class... Args>
+  requires std::constructible_from<Parent, Args&&...>
+  ClosedDerived(Args&&... args) : Parent(std::forward<Args>(args)...) {
+    this->closed_type_id_ = kId;
+  }
+  ClosedDerived(const ClosedDerived& other) noexcept(std::is_nothrow_copy_constructible_v<Parent>) : Parent(other) {
+    this->closed_type_id_ = kId;
+  }
+  // noexcept when Parent's is, so std::vector and PolyCollection segments
+  // move closed objects instead of copying them when they grow.
+  ClosedDerived(ClosedDerived&& other) noexcept(std::is_nothrow_move_constructible_v<Parent>)
+    : Parent(std::move(other)) {
+    this->closed_type_id_ = kId;
+  }
+  ClosedDerived& operator=(const ClosedDerived&) = default;
+  ClosedDerived& operator=(ClosedDerived&&) = default;
+};
+
+template <class T>
+concept ClosedHierarchy = std::derived_from<T, ClosedObject> && TypeTuple<typename T::ClosedClasses>;
+
+// Ancestor bitsets of a closed hierarchy, one per listed class (reflexive).
+template <ClosedHierarchy Root, TypeTuple Classes = typename Root::ClosedClasses>
+struct ClosedAncestors;
+
+template <ClosedHierarchy Root, class... Classes>
+struct ClosedAncestors<Root, TTuple<Classes...>> {
+  static constexpr size_t Size = sizeof...(Classes);
+  static constexpr size_t Words = (Size + 63) / 64;
+  using Bitset = std::array<uint64_t, Words>;
+
+  template <class Class>
+  static consteval Bitset Build() {
+    Bitset result{};
+    size_t index = 0;
+    ((result[index / 64] |= uint64_t(std::derived_from<Class, Classes>) << (index % 64), ++index), ...);
+    return result;
+  }
+
+  // The extra trailing entry stands for objects whose class is not listed (abstract roots).
+  static constexpr std::array<Bitset, Size + 1> Table = {Build<Classes>()..., Bitset{}};
+
+  static constexpr bool Test(size_t type_id, size_t ancestor) {
+    return (Table[type_id][ancestor / 64] >> (ancestor % 64)) & 1;
+  }
+
+  template <class Ancestor>
+  static bool IsA(const Root& object) {
+    constexpr size_t index = detail::IndexOf<Ancestor, TTuple<Classes...>>;
+    static_assert(index < Size, "class is missing from the ClosedRoot class list");
+    return Test(object.ClosedTypeId(), index);
+  }
+};
+
+// Closed hierarchies map with one table lookup instead of the dynamic_cast chain.
+// Mappings arrive topologically sorted, so the first mapping whose key is an
+// ancestor of the object's class is the most derived one, exactly like map() above.
+template <class Base, class Target, class... Mappings>
+requires TargetsConvertible<TTuple<Mappings...>, Target> && ClosedHierarchy<Base>
+struct PolymorphicMapperOrdered<Base, Target, TTuple<Mappings...>> : Mappings... {
+ public:
+  using Result = Mapped<Target>;
+
+ private:
+  using Classes = typename Base::ClosedClasses;
+  using Ancestors = ClosedAncestors<Base>;
+  static constexpr size_t kNone = sizeof...(Mappings);
+
+  static_assert((true && ... && (detail::IndexOf<typename Mappings::Key, Classes> < Ancestors::Size)),
+                "every Mapping key must be listed in the ClosedRoot class list");
+
+  static consteval std::array<uint16_t, Ancestors::Size + 1> BuildTable() {
+    std::array<uint16_t, Ancestors::Size + 1> table{};
+    for (size_t type_id = 0; type_id <= Ancestors::Size; ++type_id) {
+      size_t mapping = 0;
+      [[maybe_unused]] bool found = (false || ... ||
+          (Ancestors::Test(type_id, detail::IndexOf<typename Mappings::Key, Classes>) || (++mapping, false)));
+      table[type_id] = uint16_t(mapping);
+    }
+    return table;
+  }
+
+  static std::optional<Result> None() {
+    return std::nullopt;
+  }
+
+  static constexpr std::array<uint16_t, Ancestors::Size + 1> kTable = BuildTable();
+  static constexpr std::optional<Result> (*kExtract[kNone + 1])() = {
+      &Mappings::template Extract<Result>..., &None};
+
+ public:
+  static std::optional<Result> map(const Base& object) {
+    return kExtract[kTable[object.ClosedTypeId()]]();
+  }
+
+  static void mapBatch(Span<const Base* const> objects, Span<std::optional<Result>> results) {
+    assert(objects.Size() == results.Size());
+    for (size_t i = 0; i < objects.Size(); ++i) {
+      results[i] = objects[i] ? map(*objects[i]) : std::nullopt;
+    }
+  }
+};
@@ -3,8 +3,22 @@
 #include <stdexcept>
 #include <string_view>
 #include <algorithm>
+#include <compare>
+#include <cstdint>
 
 
+namespace detail {
+
+// FNV-1a, usable both at compile time and at run time.
+constexpr uint64_t StringHash(std::string_view string) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (char c : string) {
+    hash = (hash ^ uint8_t(c)) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+}  // namespace detail
 
 template<size_t max_length>
 struct FixedString {
@@ -16,6 +30,13 @@ struct FixedString {
     std::ranges::copy(string, string + length, data_);
     std::ranges::fill(data_ + length, data_ + max_length, '\0');
   }
+
+  // Implicit when the capacity grows, explicit (and checked) when it shrinks.
+  template<size_t other_length>
+  constexpr explicit(other_length > max_length) FixedString(const FixedString<other_length>& other)
+  : FixedString(other.data_, other.size_)
+  {}
+
   constexpr operator std::string_view() const {
     return std::string_view(data_, size_);
   }
@@ -28,6 +49,29 @@ struct FixedString {
     ++size_;
   }
 
+  constexpr uint64_t Hash() const {
+    return detail::StringHash(*this);
+  }
+
+  template<size_t other_length>
+  friend constexpr bool operator==(const FixedString& lhs, const FixedString<other_length>& rhs) {
+    return std::string_view(lhs) == std::string_view(rhs);
+  }
+
+  template<size_t other_length>
+  friend constexpr std::strong_ordering operator<=>(const FixedString& lhs, const FixedString<other_length>& rhs) {
+    return std::string_view(lhs) <=> std::string_view(rhs);
+  }
+
+  template<size_t other_length>
+  friend constexpr FixedString<max_length + other_length> operator+(const FixedString& lhs,
+                                                                    const FixedString<other_length>& rhs) {
+    FixedString<max_length + other_length> result(lhs.data_, lhs.size_);
+    std::ranges::copy(rhs.data_, rhs.data_ + rhs.size_, result.data_ + result.size_);
+    result.size_ += rhs.size_;
+    return result;
+  }
+
   char data_[max_length];
   size_t size_;
 
@@ -41,8 +85,9 @@ struct FixedString {
   }
 };
 
+// The literal keeps its terminating zero, so "abc"_cstr is a FixedString<4>.
 template<FixedString A>
 consteval auto operator""_cstr()
 {
-    return FixedString<256>(A.data_, A.size_ - 1);
+    return FixedString<sizeof(A.data_)>(A.data_, A.size_ - 1);
 }
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <PolymorphicMapper.hpp>
+
+// Handler for a pair of dynamic types: chosen when the first argument derives
+// from First and the second from Second.
+template <class First, class Second, auto handler>
+struct Mapping2 {
+  using FirstKey = First;
+  using SecondKey = Second;
+  static constexpr auto Handler = handler;
+};
+
+namespace detail {
+
+template <TypeTuple TT, typename Indices>
+struct DeduplicatedBase;
+
+template <typename... List, size_t... I>
+struct DeduplicatedBase<TTuple<List...>, std::index_sequence<I...>> {
+  using Type = Merge<std::conditional_t<FirstIndexOf<List, List...>() == I, TTuple<List>, TTuple<>>...>;
+};
+
+// TT with every repeated element dropped; the first occurrence stays in place.
+template <TypeTuple TT>
+using Deduplicated = typename DeduplicatedBase<TT, std::make_index_sequence<SizeOf<TT>>>::Type;
+
+template <TypeTuple Firsts, TypeTuple Seconds, class... Mappings>
+struct DispatchTable;
+
+template <class... Firsts, class... Seconds, class... Mappings>
+struct DispatchTable<TTuple<Firsts...>, TTuple<Seconds...>, Mappings...> {
+  static constexpr size_t Rows = sizeof...(Firsts) + 1;
+  static constexpr size_t Columns = sizeof...(Seconds) + 1;
+  static constexpr size_t Miss = sizeof...(Mappings);
+
+  template <class Key, class... Candidates>
+  static constexpr std::array<bool, sizeof...(Candidates)> DerivedRow = {std::derived_from<Key, Candidates>...};
+
+  // The trailing rows and columns stand for objects no key matches.
+  static constexpr std::array<std::array<bool, Miss>, Rows> FirstMatches = {
+      DerivedRow<Firsts, typename Mappings::FirstKey...>..., std::array<bool, Miss>{}};
+  static constexpr std::array<std::array<bool, Miss>, Columns> SecondMatches = {
+      DerivedRow<Seconds, typename Mappings::SecondKey...>..., std::array<bool, Miss>{}};
+
+  // Covers[m][n]: mapping m is at least as specific as mapping n in both arguments.
+  template <class Mapping>
+  static constexpr std::array<bool, Miss> CoversRow = {
+      (std::derived_from<typename Mapping::FirstKey, typename Mappings::FirstKey> &&
+       std::derived_from<typename Mapping::SecondKey, typename Mappings::SecondKey>)...};
+  static constexpr std::array<std::array<bool, Miss>, Miss> Covers = {CoversRow<Mappings>...};
+
+  // Index of the mapping whose keys are the most derived among those matching the
+  // cell, Miss if none matches, and Miss + 1 if no single one is the most derived.
+  static consteval size_t Choose(size_t row, size_t column) {
+    size_t chosen = Miss;
+    for (size_t m = 0; m < Miss; ++m) {
+      if (!FirstMatches[row][m] || !SecondMatches[column][m]) {
+        continue;
+      }
+      bool best = true;
+      for (size_t n = 0; n < Miss; ++n) {
+        if (n != m && FirstMatches[row][n] && SecondMatches[column][n] && !(Covers[m][n] && !Covers[n][m])) {
+          best = false;
+        }
+      }
+      if (best) {
+        return m;
+      }
+      chosen = Miss + 1;
+    }
+    return chosen;
+  }
+
+  static consteval std::array<uint16_t, Rows * Columns> Build() {
+    std::array<uint16_t, Rows * Columns> cells{};
+    for (size_t row = 0; row < Rows; ++row) {
+      for (size_t column = 0; column < Columns; ++column) {
+        cells[row * Columns + column] = uint16_t(Choose(row, column));
+      }
+    }
+    return cells;
+  }
+
+  static constexpr std::array<uint16_t, Rows * Columns> Cells = Build();
+  static constexpr bool Ambiguous = std::ranges::find(Cells, Miss + 1) != Cells.end();
+};
+
+template <class R>
+struct DispatchResultBase {
+  using Type = std::optional<R>;
+};
+
+template <>
+struct DispatchResultBase<void> {
+  using Type = bool;
+};
+
+}  // namespace detail
+
+// Double dispatch over the dynamic types of two Base arguments.
+// Each argument is resolved once to the index of its most derived key, as
+// PolymorphicMapper would do for it; the pair then selects the handler from a
+// table built at compile time, and the handler is reached with one indirect call.
+// A handler is chosen when both of its keys match and it is more derived than every
+// other matching handler in both arguments; pairs of keys for which no handler is
+// the most derived are rejected by a static_assert.
+// map() returns the handler's result (true for void handlers), or an empty
+// optional (false) when no handler matches.
+template <class Base, class... Mappings>
+requires (sizeof...(Mappings) > 0) &&
+         (std::derived_from<typename Mappings::FirstKey, Base> && ...) &&
+         (std::derived_from<typename Mappings::SecondKey, Base> && ...)
+struct MultiMapper {
+ private:
+  template <class Mapping>
+  using HandlerResult = std::invoke_result_t<decltype(Mapping::Handler), const typename Mapping::FirstKey&,
+                                             const typename Mapping::SecondKey&>;
+
+  using Front = HandlerResult<detail::TypeAt<0, TTuple<Mappings...>>>;
+  using Firsts = detail::Deduplicated<TTuple<typename Mappings::FirstKey...>>;
+  using Seconds = detail::Deduplicated<TTuple<typename Mappings::SecondKey...>>;
+  using Table = detail::DispatchTable<Firsts, Seconds, Mappings...>;
+
+  static_assert((true && ... && std::same_as<HandlerResult<Mappings>, Front>), "all handlers must return the same type");
+  static_assert(!Table::Ambiguous, "ambiguous handlers: no single most derived handler for some pair of keys");
+
+ public:
+  using Result = typename detail::DispatchResultBase<Front>::Type;
+
+  static Result map(const Base& first, const Base& second) {
+    size_t row = detail::KeyResolver<Base, Firsts>::map(first).value_or(Table::Rows - 1);
+    size_t column = detail::KeyResolver<Base, Seconds>::map(second).value_or(Table::Columns - 1);
+    return kHandlers[Table::Cells[row * Table::Columns + column]](first, second);
+  }
+
+ private:
+  template <class Mapping>
+  static Result Call(const Base& first, const Base& second) {
+    const auto& lhs = static_cast<const typename Mapping::FirstKey&>(first);
+    const auto& rhs = static_cast<const typename Mapping::SecondKey&>(second);
+    if constexpr (std::is_void_v<HandlerResult<Mapping>>) {
+      std::invoke(Mapping::Handler, lhs, rhs);
+      return true;
+    } else {
+      return std::invoke(Mapping::Handler, lhs, rhs);
+    }
+  }
+
+  static Result Miss(const Base&, const Base&) {
+    return Result{};
+  }
+
+  static constexpr Result (*kHandlers[Table::Miss + 1])(const Base&, const Base&) = {&Call<Mappings>..., &Miss};
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <PolymorphicMapper.hpp>
+#include <Span.hpp>
+
+template <class Base, TypeTuple Classes>
+class PolyCollection;
+
+// Heterogeneous collection of objects derived from Base, stored by value with
+// one contiguous segment per concrete class. for_each walks the segments one
+// after another and hands every element over with its static type, so calls
+// on it need no vtable (guaranteed when the classes are final).
+// Inserting through a reference to Base, or to a class with listed descendants,
+// finds the segment with the same most-derived rule as PolymorphicMapper.
+template <class Base, class... Classes>
+requires UniqueSeq<Classes...> && (std::derived_from<Classes, Base> && ...) && (!std::is_abstract_v<Classes> && ...)
+class PolyCollection<Base, TTuple<Classes...>> {
+ public:
+  static constexpr size_t Segments = sizeof...(Classes);
+
+  template <class T>
+  static constexpr bool Stores = detail::FirstIndexOf<T, Classes...>() < Segments;
+
+  template <class T, class... Args>
+  requires Stores<T>
+  T& emplace(Args&&... args) {
+    return SegmentVector<T>().emplace_back(std::forward<Args>(args)...);
+  }
+
+  // Inserts into the segment of T. If another listed class derives from T, a
+  // T reference may name one of those, so the segment is picked from the
+  // dynamic type as in insert(const Base&) below and a Kitten passed as Cat&
+  // is not sliced into Cat. Rvalues are moved in either case. Base references
+  // of any kind go to insert(const Base&).
+  template <class T>
+  requires Stores<std::remove_cvref_t<T>> && (!std::same_as<std::remove_cvref_t<T>, Base>)
+  std::remove_cvref_t<T>& insert(T&& object) {
+    using Class = std::remove_cvref_t<T>;
+    if constexpr (kHasListedDescendants<Class>) {
+      size_t index = *Resolver::map(object);
+      if constexpr (std::is_rvalue_reference_v<T&&> && !std::is_const_v<std::remove_reference_t<T>>) {
+        return static_cast<Class&>(*kMove[index](*this, object));
+      } else {
+        return static_cast<Class&>(*kCopy[index](*this, object));
+      }
+    } else {
+      return emplace<Class>(std::forward<T>(object));
+    }
+  }
+
+  // Copies object, sliced to its most derived listed class, into that class's segment.
+  // Returns nullptr, and stores nothing, if no listed class matches.
+  Base* insert(const Base& object) {
+    std::optional<size_t> index = Resolver::map(object);
+    if (!index) {
+      return nullptr;
+    }
+    return kCopy[*index](*this, object);
+  }
+
+  template <class T>
+  requires Stores<T>
+  Span<T> segment() {
+    std::vector<T>& items = SegmentVector<T>();
+    return Span<T>(items.data(), items.size());
+  }
+
+  template <class T>
+  requires Stores<T>
+  Span<const T> segment() const {
+    const std::vector<T>& items = std::get<std::vector<T>>(segments_);
+    return Span<const T>(items.data(), items.size());
+  }
+
+  // Calls f(T&) for every element, segment by segment in the order of Classes.
+  template <class F>
+  void for_each(F&& f) {
+    std::apply([&f](auto&... items) { (ForEach(items, f), ...); }, segments_);
+  }
+
+  template <class F>
+  void for_each(F&& f) const {
+    std::apply([&f](const auto&... items) { (ForEach(items, f), ...); }, segments_);
+  }
+
+  size_t size() const {
+    return std::apply([](const auto&... items) { return (size_t(0) + ... + items.size()); }, segments_);
+  }
+
+  bool empty() const {
+    return size() == 0;
+  }
+
+  void clear() {
+    std::apply([](auto&... items) { (items.clear(), ...); }, segments_);
+  }
+
+  template <class T>
+  requires Stores<T>
+  void reserve(size_t count) {
+    SegmentVector<T>().reserve(count);
+  }
+
+ private:
+  using Resolver = detail::KeyResolver<Base, TTuple<Classes...>>;
+
+  template <class T>
+  static constexpr bool kHasListedDescendants = ((!std::same_as<T, Classes> && std::derived_from<Classes, T>) || ...);
+
+  template <class T>
+  std::vector<T>& SegmentVector() {
+    return std::get<std::vector<T>>(segments_);
+  }
+
+  template <class Items, class F>
+  static void ForEach(Items& items, F& f) {
+    for (auto& item : items) {
+      f(item);
+    }
+  }
+
+  template <class T>
+  static Base* Copy(PolyCollection& collection, const Base& object) {
+    return &collection.emplace<T>(static_cast<const T&>(object));
+  }
+
+  template <class T>
+  static Base* Move(PolyCollection& collection, Base& object) {
+    return &collection.emplace<T>(std::move(static_cast<T&>(object)));
+  }
+
+  static constexpr Base* (*kCopy[Segments])(PolyCollection&, const Base&) = {&Copy<Classes>...};
+  static constexpr Base* (*kMove[Segments])(PolyCollection&, Base&) = {&Move<Classes>...};
+
+  std::tuple<std::vector<Classes>...> segments_;
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <PolymorphicMapper.hpp>
+
+namespace detail {
+
+constexpr size_t TagSlot(uint64_t hash, uint32_t displacement, size_t slots) {
+  uint64_t mixed = (hash ^ (displacement * 0x9e3779b97f4a7c15ull)) * 0xff51afd7ed558ccdull;
+  return (mixed >> 32) & (slots - 1);
+}
+
+constexpr size_t TagBucket(uint64_t hash, size_t buckets) {
+  return hash & (buckets - 1);
+}
+
+constexpr size_t PowerOfTwoAtLeast(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result *= 2;
+  }
+  return result;
+}
+
+// Hash-and-displace perfect hash over N tags: every tag falls into one of
+// Buckets buckets, and each bucket gets the smallest displacement that moves
+// all of its tags into free slots. Lookup is two table loads and one compare.
+template <size_t N>
+struct TagTable {
+  static constexpr size_t Buckets = PowerOfTwoAtLeast((N + 1) / 2);
+  static constexpr size_t Slots = PowerOfTwoAtLeast(2 * N);
+  static constexpr uint32_t MaxDisplacement = 1u << 16;
+
+  std::array<uint32_t, Buckets> displacements{};
+  // Index of the tag in the slot plus one, zero for an empty slot.
+  std::array<uint16_t, Slots> entries{};
+  bool duplicates = false;
+  bool collisions = false;
+
+  consteval explicit TagTable(const std::array<std::string_view, N>& tags) {
+    std::array<uint64_t, N> hashes{};
+    for (size_t i = 0; i < N; ++i) {
+      hashes[i] = StringHash(tags[i]);
+      for (size_t j = 0; j < i; ++j) {
+        if (hashes[i] == hashes[j]) {
+          (tags[i] == tags[j] ? duplicates : collisions) = true;
+        }
+      }
+    }
+    if (duplicates || collisions) {
+      return;
+    }
+
+    // Tags grouped by bucket: members[starts[b]..starts[b + 1]) belong to bucket b.
+    std::array<size_t, Buckets + 1> starts{};
+    for (size_t i = 0; i < N; ++i) {
+      ++starts[TagBucket(hashes[i], Buckets) + 1];
+    }
+    for (size_t bucket = 0; bucket < Buckets; ++bucket) {
+      starts[bucket + 1] += starts[bucket];
+    }
+    std::array<size_t, N> members{};
+    std::array<size_t, Buckets> filled{};
+    for (size_t i = 0; i < N; ++i) {
+      size_t bucket = TagBucket(hashes[i], Buckets);
+      members[starts[bucket] + filled[bucket]++] = i;
+    }
+
+    // Largest buckets first: they are the hardest to place.
+    std::array<size_t, Buckets> order{};
+    for (size_t bucket = 0; bucket < Buckets; ++bucket) {
+      order[bucket] = bucket;
+    }
+    for (size_t i = 1; i < Buckets; ++i) {
+      for (size_t j = i; j > 0 && filled[order[j - 1]] < filled[order[j]]; --j) {
+        std::swap(order[j - 1], order[j]);
+      }
+    }
+
+    for (size_t bucket : order) {
+      if (filled[bucket] == 0) {
+        break;
+      }
+      uint32_t displacement = 0;
+      while (!TryPlace(&members[starts[bucket]], filled[bucket], displacement, hashes)) {
+        if (++displacement == MaxDisplacement) {
+          collisions = true;
+          return;
+        }
+      }
+      displacements[bucket] = displacement;
+    }
+  }
+
+  constexpr std::optional<size_t> Find(std::string_view tag, const std::array<std::string_view, N>& tags) const {
+    uint64_t hash = StringHash(tag);
+    size_t slot = TagSlot(hash, displacements[TagBucket(hash, Buckets)], Slots);
+    size_t entry = entries[slot];
+    if (entry == 0 || tags[entry - 1] != tag) {
+      return std::nullopt;
+    }
+    return entry - 1;
+  }
+
+ private:
+  consteval bool TryPlace(const size_t* bucket, size_t size, uint32_t displacement,
+                          const std::array<uint64_t, N>& hashes) {
+    for (size_t i = 0; i < size; ++i) {
+      size_t slot = TagSlot(hashes[bucket[i]], displacement, Slots);
+      if (entries[slot] != 0) {
+        for (size_t j = 0; j < i; ++j) {
+          entries[TagSlot(hashes[bucket[j]], displacement, Slots)] = 0;
+        }
+        return false;
+      }
+      entries[slot] = uint16_t(bucket[i] + 1);
+    }
+    return true;
+  }
+};
+
+}  // namespace detail
+
+// Deleter of the objects PolymorphicFactory::make creates: remembers the
+// dynamic type's destroy-and-deallocate routine next to the allocator.
+template <class Base, class Allocator>
+struct FactoryDeleter {
+  Allocator allocator;
+  void (*destroy)(Allocator&, Base*);
+
+  void operator()(Base* object) {
+    destroy(allocator, object);
+  }
+};
+
+// Reverse of PolymorphicMapper: builds the Mapping key whose target equals a tag.
+// Built from the same Mapping list; targets must convert to std::string_view.
+// Tags are resolved through a perfect hash computed at compile time, and
+// duplicate or colliding tags are rejected by a static_assert.
+// Keys that cannot be constructed from the given arguments (e.g. abstract
+// bases listed for the mapper) are found but never built: the call returns nullptr.
+template <class Base, class... Mappings>
+requires (sizeof...(Mappings) > 0) && (std::derived_from<typename Mappings::Key, Base> && ...)
+struct PolymorphicFactory {
+  static_assert(sizeof...(Mappings) < UINT16_MAX, "too many mappings");
+
+  static constexpr size_t StorageSize = std::max({size_t(1), sizeof(typename Mappings::Key)...});
+  static constexpr size_t StorageAlign = std::max({alignof(std::max_align_t), alignof(typename Mappings::Key)...});
+
+  // A buffer any of the keys can be constructed in.
+  struct Storage {
+    alignas(StorageAlign) std::byte data[StorageSize];
+  };
+
+  static constexpr bool contains(std::string_view tag) {
+    return kTable.Find(tag, kTags).has_value();
+  }
+
+  // Constructs the key mapped to tag in buffer, which must hold StorageSize bytes
+  // aligned to StorageAlign. Returns nullptr if no key is mapped to tag.
+  template <class... Args>
+  static Base* construct(std::string_view tag, void* buffer, Args&&... args) {
+    std::optional<size_t> index = kTable.Find(tag, kTags);
+    if (!index) {
+      return nullptr;
+    }
+    return kConstruct<Args&&...>[*index](buffer, std::forward<Args>(args)...);
+  }
+
+  template <class Allocator = std::allocator<Base>>
+  using Pointer = std::unique_ptr<Base, FactoryDeleter<Base, Allocator>>;
+
+  // Allocates and constructs the key mapped to tag through allocator, passed
+  // after std::allocator_arg as in the standard library.
+  // Returns an empty pointer if no key is mapped to tag.
+  template <class Allocator, class... Args>
+  static Pointer<Allocator> make(std::allocator_arg_t, const Allocator& allocator, std::string_view tag, Args&&... args) {
+    std::optional<size_t> index = kTable.Find(tag, kTags);
+    if (!index) {
+      return Pointer<Allocator>(nullptr, {allocator, nullptr});
+    }
+    return kMake<Allocator, Args&&...>[*index](allocator, std::forward<Args>(args)...);
+  }
+
+  // Same through std::allocator<Base>.
+  template <class... Args>
+  static Pointer<> make(std::string_view tag, Args&&... args) {
+    return make(std::allocator_arg, std::allocator<Base>(), tag, std::forward<Args>(args)...);
+  }
+
+ private:
+  static constexpr size_t kSize = sizeof...(Mappings);
+  static constexpr std::array<std::string_view, kSize> kTags = {std::string_view(Mappings::Value)...};
+  static constexpr detail::TagTable<kSize> kTable{kTags};
+
+  static_assert(!kTable.duplicates, "two mappings share the same tag");
+  static_assert(!kTable.collisions, "no perfect hash found for the mapping tags");
+
+  template <class Key, class... Args>
+  static Base* Construct(void* buffer, Args... args) {
+    if constexpr (std::constructible_from<Key, Args...>) {
+      return ::new (buffer) Key(std::forward<Args>(args)...);
+    } else {
+      return nullptr;
+    }
+  }
+
+  template <class Key, class Allocator>
+  static void Destroy(Allocator& allocator, Base* object) {
+    using Traits = typename std::allocator_traits<Allocator>::template rebind_traits<Key>;
+    typename Traits::allocator_type rebound(allocator);
+    Key* key = static_cast<Key*>(object);
+    Traits::destroy(rebound, key);
+    Traits::deallocate(rebound, key, 1);
+  }
+
+  template <class Key, class Allocator, class... Args>
+  static Pointer<Allocator> Make(const Allocator& allocator, Args... args) {
+    if constexpr (std::constructible_from<Key, Args...>) {
+      using Traits = typename std::allocator_traits<Allocator>::template rebind_traits<Key>;
+      typename Traits::allocator_type rebound(allocator);
+      Key* key = Traits::allocate(rebound, 1);
+      try {
+        Traits::construct(rebound, key, std::forward<Args>(args)...);
+      } catch (...) {
+        Traits::deallocate(rebound, key, 1);
+        throw;
+      }
+      return Pointer<Allocator>(key, {allocator, &Destroy<Key, Allocator>});
+    } else {
+      return Pointer<Allocator>(nullptr, {allocator, nullptr});
+    }
+  }
+
+  template <class... Args>
+  static constexpr Base* (*kConstruct[kSize])(void*, Args...) = {&Construct<typename Mappings::Key, Args...>...};
+
+  template <class Allocator, class... Args>
+  static constexpr Pointer<Allocator> (*kMake[kSize])(const Allocator&, Args...) = {
+      &Make<typename Mappings::Key, Allocator, Args...>...};
+};
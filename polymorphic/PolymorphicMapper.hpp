@@ -1,8 +1,15 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
 #include <concepts>
 #include <optional>
+#include <string_view>
+#include <typeinfo>
+#include <utility>
 #include <FixedString.hpp>
+#include <Span.hpp>
 
 template<typename... T>
 struct TTuple {};
@@ -14,6 +21,12 @@ template <class From, auto target>
 struct Mapping {
   using Key = From;
   using TTarget = decltype(target);
+  static constexpr TTarget Value = target;
+
+  template<typename Target>
+  static std::optional<Target> Extract() {
+    return {target};
+  }
 
   template<typename Target, typename Base>
   static std::optional<Target> TryExtract(const Base& object) {
@@ -43,21 +56,93 @@ concept AllSame = TypeTuple<TT> && (AllSameBase<Proj, TT>::Value);
 template <typename T>
 using GetTTarget = typename T::TTarget;
 
-template <class Base, class Target, AllSame<GetTTarget> Mappings>
+template <TypeTuple TT, class Target>
+struct TargetsConvertibleBase;
+
+template <class... Mappings, class Target>
+struct TargetsConvertibleBase<TTuple<Mappings...>, Target> {
+  constexpr static bool Value = (true && ... && std::convertible_to<GetTTarget<Mappings>, Target>);
+};
+
+template <typename TT, class Target>
+concept TargetsConvertible = TypeTuple<TT> && (TargetsConvertibleBase<TT, Target>::Value);
+
+// What map() hands out for a Target: FixedString targets already live in static
+// storage (they are template parameter objects), so they are returned as views.
+template <class Target>
+struct MappedBase {
+  using Type = Target;
+};
+
+template <size_t max_length>
+struct MappedBase<FixedString<max_length>> {
+  using Type = std::string_view;
+};
+
+template <class Target>
+using Mapped = typename MappedBase<Target>::Type;
+
+template <class Base, class Target, TargetsConvertible<Target> Mappings>
 struct PolymorphicMapperOrdered;
 
 template <class Base, class Target, class... Mappings>
-requires AllSame<TTuple<Mappings...>, GetTTarget>
+requires TargetsConvertible<TTuple<Mappings...>, Target>
 struct PolymorphicMapperOrdered<Base, Target, TTuple<Mappings...>> : Mappings...{
-  static std::optional<Target> map(const Base& object) {
-    std::optional<Target> result;
-    auto op = [](std::optional<Target>(*v)(const Base&), std::optional<Target>& result, const Base& object) {
+  using Result = Mapped<Target>;
+
+  static std::optional<Result> map(const Base& object) {
+    std::optional<Result> result;
+    auto op = [](std::optional<Result>(*v)(const Base&), std::optional<Result>& result, const Base& object) {
       result = v(object);
       return bool(result);
     };
-    [[maybe_unused]] bool found = (false || ... || op(&Mappings::template TryExtract<Target, Base>, result, object));
+    [[maybe_unused]] bool found = (false || ... || op(&Mappings::template TryExtract<Result, Base>, result, object));
     return result;
   }
+
+#ifdef __cpp_rtti
+  // Runs the cast chain once per distinct dynamic type met in the batch.
+  // Null pointers map to std::nullopt.
+  static void mapBatch(Span<const Base* const> objects, Span<std::optional<Result>> results) {
+    assert(objects.Size() == results.Size());
+    constexpr size_t kMaxTypes = 16;
+    constexpr size_t kPrefetchDistance = 8;
+    const std::type_info* types[kMaxTypes];
+    std::optional<Result> resolved[kMaxTypes];
+    size_t known = 0;
+    size_t last = 0;
+    for (size_t i = 0; i < objects.Size(); ++i) {
+      if (i + kPrefetchDistance < objects.Size()) {
+        __builtin_prefetch(objects[i + kPrefetchDistance]);
+      }
+      const Base* object = objects[i];
+      if (object == nullptr) {
+        results[i] = std::nullopt;
+        continue;
+      }
+      const std::type_info& info = typeid(*object);
+      if (last < known && types[last] == &info) {
+        results[i] = resolved[last];
+        continue;
+      }
+      size_t group = 0;
+      while (group < known && types[group] != &info && *types[group] != info) {
+        ++group;
+      }
+      if (group == known) {
+        if (known == kMaxTypes) {
+          results[i] = map(*object);
+          continue;
+        }
+        types[known] = &info;
+        resolved[known] = map(*object);
+        ++known;
+      }
+      last = group;
+      results[i] = resolved[group];
+    }
+  }
+#endif
 };
 
 namespace detail {
@@ -91,18 +176,28 @@ using Merge = typename MergeBase<T...>::Type;
 
 using detail::Merge;
 
+namespace detail {
+
+template <size_t N>
+consteval size_t CountTrue(const std::array<bool, N>& flags) {
+  size_t count = 0;
+  for (bool flag : flags) {
+    count += flag;
+  }
+  return count;
+}
+
+}  // namespace detail
+
+template<typename T, typename... List>
+constexpr size_t CountOf = detail::CountTrue<sizeof...(List)>({__is_same(T, List)...});
+
 template<TypeTuple T>
 struct UniqueBase;
 
-template<typename Head, typename... Tail>
-struct UniqueBase<TTuple<Head, Tail...>> {
-  static constexpr bool FirstIsUnique = (true && ... && !std::same_as<Head, Tail>);
-  static constexpr bool Value = FirstIsUnique && UniqueBase<TTuple<Tail...>>::Value;
-};
-
-template<>
-struct UniqueBase<TTuple<>> {
-  static constexpr bool Value = true;
+template<typename... List>
+struct UniqueBase<TTuple<List...>> {
+  static constexpr bool Value = (true && ... && (CountOf<List, List...> == 1));
 };
 
 template<typename T>
@@ -111,50 +206,111 @@ concept UniqueTuple = TypeTuple<T> && (UniqueBase<T>::Value);
 template<typename... T>
 concept UniqueSeq = UniqueTuple<TTuple<T...>>;
 
-template <template <class> class Proj,typename... List>
-struct FilterDerivators;
+namespace detail {
 
-template <template <class> class Proj, typename T, typename Head, typename... Tail>
-requires (!std::derived_from<Proj<Head>, Proj<T>>)
-struct FilterDerivators<Proj, T, Head, Tail...> {
-  using Derivators = typename FilterDerivators<Proj, T, Tail...>::Derivators;
-  using Remains = detail::Merge2<TTuple<Head>, typename FilterDerivators<Proj, T, Tail...>::Remains>;
-};
+template <TypeTuple TT>
+struct SizeOfBase;
 
-template <template <class> class Proj, typename T, typename Head,typename... Tail>
-requires std::derived_from<Proj<Head>, Proj<T>> 
-struct FilterDerivators<Proj, T, Head, Tail...> {
-  using Derivators = Merge<TTuple<Head>, typename FilterDerivators<Proj, T, Tail...>::Derivators>;
-  using Remains = FilterDerivators<Proj, T, Tail...>::Remains;
+template <class... Ts>
+struct SizeOfBase<TTuple<Ts...>> {
+  static constexpr size_t Value = sizeof...(Ts);
 };
 
-template <template <class> class Proj, typename T>
-struct FilterDerivators<Proj, T> {
-  using Derivators = TTuple<>;
-  using Remains = TTuple<>;
-};
+template <TypeTuple TT>
+constexpr size_t SizeOf = SizeOfBase<TT>::Value;
 
-template <template <class> class Proj, UniqueTuple Tuple>
-struct TopologicallySortedBase;
+template <typename T, typename... List>
+consteval size_t FirstIndexOf() {
+  constexpr std::array<bool, sizeof...(List)> same = {__is_same(T, List)...};
+  size_t index = 0;
+  while (index < same.size() && !same[index]) {
+    ++index;
+  }
+  return index;
+}
 
-template<template <class> class Proj, typename T, typename... List>
-requires UniqueTuple<TTuple<T, List...>>
-struct TopologicallySortedBase<Proj, TTuple<T, List...>> {
-  using Splitted = FilterDerivators<Proj, T, List...>;
-  using Reordered = Merge<typename Splitted::Derivators, TTuple<T>, typename Splitted::Remains>;
-  static_assert(TypeTuple<Merge<typename Splitted::Derivators, TTuple<T>, typename Splitted::Remains>>);
-  using Type = TopologicallySortedBase<Proj, Reordered>::Type;
+template <size_t I, typename T>
+struct Indexed {
+  using Type = T;
 };
 
-template<template <class> class Proj, typename T, typename... List>
-requires UniqueTuple<TTuple<T, List...>> && std::same_as<typename FilterDerivators<Proj, T, List...>::Derivators, TTuple<>>
-struct TopologicallySortedBase<Proj, TTuple<T, List...>> {
-  using Type = Merge<TTuple<T>, typename TopologicallySortedBase<Proj, TTuple<List...>>::Type>;
+template <typename Indices, typename... List>
+struct IndexerBase;
+
+template <size_t... I, typename... List>
+struct IndexerBase<std::index_sequence<I...>, List...> : Indexed<I, List>... {};
+
+template <size_t I, typename T>
+Indexed<I, T> SelectIndexed(const Indexed<I, T>&);
+
+template <TypeTuple TT>
+struct Indexer;
+
+template <typename... List>
+struct Indexer<TTuple<List...>> : IndexerBase<std::index_sequence_for<List...>, List...> {};
+
+// O(1) instantiation depth, unlike peeling the tuple head by head.
+template <size_t I, TypeTuple TT>
+using TypeAt = typename decltype(SelectIndexed<I>(std::declval<Indexer<TT>>()))::Type;
+
+template <TypeTuple TT, auto order, typename Indices = std::make_index_sequence<order.size()>>
+struct PermutedBase;
+
+template <TypeTuple TT, auto order, size_t... I>
+struct PermutedBase<TT, order, std::index_sequence<I...>> {
+  using Type = TTuple<TypeAt<order[I], TT>...>;
 };
 
-template<template <class> class Proj>
-struct TopologicallySortedBase<Proj, TTuple<>> {
-  using Type = TTuple<>;
+// Reorders TT so that its I-th element is the order[I]-th element of TT.
+template <TypeTuple TT, auto order>
+using Permuted = typename PermutedBase<TT, order>::Type;
+
+// Bottom-up merge sort of the indices 0..N-1 by ranks: stable and logarithmic in depth,
+// and evaluated as one constant expression instead of a template recursion.
+template <size_t N>
+consteval std::array<size_t, N> StableOrderByRank(const std::array<size_t, N>& ranks) {
+  std::array<size_t, N> order{};
+  std::array<size_t, N> buffer{};
+  for (size_t i = 0; i < N; ++i) {
+    order[i] = i;
+  }
+  for (size_t width = 1; width < N; width *= 2) {
+    for (size_t left = 0; left < N; left += 2 * width) {
+      size_t middle = std::min(left + width, N);
+      size_t right = std::min(left + 2 * width, N);
+      size_t i = left;
+      size_t j = middle;
+      for (size_t k = left; k < right; ++k) {
+        if (i < middle && (j == right || ranks[order[i]] <= ranks[order[j]])) {
+          buffer[k] = order[i++];
+        } else {
+          buffer[k] = order[j++];
+        }
+      }
+    }
+    order = buffer;
+  }
+  return order;
+}
+
+}  // namespace detail
+
+// Number of keys in List (T itself included) derived from T.
+// A base always ranks strictly above each of its derivators, so sorting by rank is topological.
+template <typename T, typename... List>
+constexpr size_t DerivatorsCount = detail::CountTrue<sizeof...(List)>({__is_base_of(T, List)...});
+
+template <typename... Keys>
+constexpr std::array<size_t, sizeof...(Keys)> DerivatorsCounts = {DerivatorsCount<Keys, Keys...>...};
+
+template <template <class> class Proj, UniqueTuple Tuple>
+struct TopologicallySortedBase;
+
+template<template <class> class Proj, typename... List>
+requires UniqueTuple<TTuple<List...>>
+struct TopologicallySortedBase<Proj, TTuple<List...>> {
+  static constexpr std::array<size_t, sizeof...(List)> Ranks = DerivatorsCounts<Proj<List>...>;
+  using Type = detail::Permuted<TTuple<List...>, detail::StableOrderByRank(Ranks)>;
 };
 
 template<typename T>
@@ -168,3 +324,20 @@ using GetKey = typename T::Key;
 
 template <class Base, class Target, class... Mappings>
 using PolymorphicMapper = PolymorphicMapperOrdered<Base, Target, TopologicallySorted<TTuple<Mappings...>, GetKey>>;
+
+namespace detail {
+
+template <class Base, TypeTuple Keys, typename Indices>
+struct KeyResolverBase;
+
+template <class Base, class... Keys, size_t... I>
+struct KeyResolverBase<Base, TTuple<Keys...>, std::index_sequence<I...>> {
+  using Type = PolymorphicMapper<Base, size_t, Mapping<Keys, I>...>;
+};
+
+// Maps an object to the index in Keys of its most derived key, with the
+// same rules (and the same closed-hierarchy fast path) as PolymorphicMapper.
+template <class Base, TypeTuple Keys>
+using KeyResolver = typename KeyResolverBase<Base, Keys, std::make_index_sequence<SizeOf<Keys>>>::Type;
+
+}  // namespace detail
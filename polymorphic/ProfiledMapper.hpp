@@ -0,0 +1,156 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <utility>
+#include <PolymorphicMapper.hpp>
+
+struct MappingProfile {
+  size_t hits;
+  size_t casts;
+};
+
+// PolymorphicMapper that records which mapping answered each call.
+// The hot path adds a single relaxed increment to PolymorphicMapper::map:
+// casts are not counted one by one but derived from the hits, since a mapping
+// is tried exactly when no mapping before it in the cast chain matched.
+// Profiles are reported in the order the mappings are declared in.
+template <class Base, class Target, class... Mappings>
+requires TargetsConvertible<TTuple<Mappings...>, Target>
+class InstrumentedMapper {
+ public:
+  using Result = Mapped<Target>;
+  static constexpr size_t Size = sizeof...(Mappings);
+
+  static std::optional<Result> map(const Base& object) {
+    return Map(object, Ordered{});
+  }
+
+  static std::array<MappingProfile, Size> Profile() {
+    std::array<MappingProfile, Size> profile{};
+    size_t tried = counters_[Size].value.load(std::memory_order_relaxed);
+    for (size_t position = Size; position-- > 0;) {
+      size_t index = kOrder[position];
+      profile[index].hits = counters_[index].value.load(std::memory_order_relaxed);
+      tried += profile[index].hits;
+      profile[index].casts = tried;
+    }
+    return profile;
+  }
+
+  // Frequency rank of every mapping (0 for the hottest), the input ProfileGuidedMapper takes.
+  static std::array<size_t, Size> Ranks() {
+    std::array<MappingProfile, Size> profile = Profile();
+    std::array<size_t, Size> ranks{};
+    for (size_t i = 0; i < Size; ++i) {
+      for (size_t j = 0; j < Size; ++j) {
+        ranks[i] += profile[j].hits > profile[i].hits || (profile[j].hits == profile[i].hits && j < i);
+      }
+    }
+    return ranks;
+  }
+
+  static size_t Misses() {
+    return counters_[Size].value.load(std::memory_order_relaxed);
+  }
+
+  static void ResetProfile() {
+    for (Counter& counter : counters_) {
+      counter.value.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // One line per mapping, then the ranks ready to paste into ProfileGuidedMapper.
+  static void DumpProfile(std::ostream& out) {
+    std::array<MappingProfile, Size> profile = Profile();
+    for (size_t i = 0; i < Size; ++i) {
+      out << "mapping " << i << ": hits " << profile[i].hits << ", casts " << profile[i].casts << '\n';
+    }
+    out << "misses: " << Misses() << '\n';
+    out << "ranks: std::index_sequence<";
+    std::array<size_t, Size> ranks = Ranks();
+    for (size_t i = 0; i < Size; ++i) {
+      out << (i == 0 ? "" : ", ") << ranks[i];
+    }
+    out << ">\n";
+  }
+
+ private:
+  using Ordered = TopologicallySorted<TTuple<Mappings...>, GetKey>;
+
+  template <class... List>
+  static consteval std::array<size_t, Size> OrderOf(TTuple<List...>) {
+    return {detail::FirstIndexOf<List, Mappings...>()...};
+  }
+
+  // Declaration index of the mapping tried at each position of the cast chain.
+  static constexpr std::array<size_t, Size> kOrder = OrderOf(Ordered{});
+
+  template <class... List>
+  static std::optional<Result> Map(const Base& object, TTuple<List...>) {
+    std::optional<Result> result;
+    size_t position = 0;
+    bool found = (false || ... || ((result = List::template TryExtract<Result, Base>(object)) || (++position, false)));
+    counters_[found ? kOrder[position] : Size].value.fetch_add(1, std::memory_order_relaxed);
+    return result;
+  }
+
+  struct alignas(64) Counter {
+    std::atomic<size_t> value{0};
+  };
+
+  // Hits per mapping in declaration order; the last counter holds the misses.
+  static inline std::array<Counter, Size + 1> counters_;
+};
+
+template <template <class> class Proj, TypeTuple Tuple, class Ranks>
+struct HotFirstSortedBase;
+
+template <template <class> class Proj, typename... List, size_t... ranks>
+requires UniqueTuple<TTuple<List...>> && (sizeof...(List) == sizeof...(ranks))
+struct HotFirstSortedBase<Proj, TTuple<List...>, std::index_sequence<ranks...>> {
+  static constexpr size_t N = sizeof...(List);
+
+  // Derivators<T>[j]: the j-th element derives from T, so it must precede T.
+  template <typename T>
+  static constexpr std::array<bool, N> Derivators = {__is_base_of(Proj<T>, Proj<List>)...};
+
+  // Topological sort that, among the elements whose derivators are all placed,
+  // always places the one with the lowest rank next.
+  static consteval std::array<size_t, N> Order() {
+    constexpr std::array<std::array<bool, N>, N> derivators = {Derivators<List>...};
+    constexpr std::array<size_t, N> rank = {ranks...};
+    std::array<bool, N> placed{};
+    std::array<size_t, N> order{};
+    for (size_t k = 0; k < N; ++k) {
+      size_t best = N;
+      for (size_t i = 0; i < N; ++i) {
+        bool ready = !placed[i];
+        for (size_t j = 0; j < N && ready; ++j) {
+          ready = j == i || !derivators[i][j] || placed[j];
+        }
+        if (ready && (best == N || rank[i] < rank[best])) {
+          best = i;
+        }
+      }
+      order[k] = best;
+      placed[best] = true;
+    }
+    return order;
+  }
+
+  using Type = detail::Permuted<TTuple<List...>, Order()>;
+};
+
+// Like TopologicallySorted, but independent elements go hottest first according
+// to Ranks, an std::index_sequence holding the rank of each element (0 = hottest).
+template <UniqueTuple Tuple, class Ranks, template <class> class Proj = Id>
+using HotFirstSorted = typename HotFirstSortedBase<Proj, Tuple, Ranks>::Type;
+
+// PolymorphicMapper whose cast chain follows a profile recorded by InstrumentedMapper.
+// Derived keys still come before their bases, so map() returns the same results.
+template <class Base, class Target, class Ranks, class... Mappings>
+using ProfileGuidedMapper = PolymorphicMapperOrdered<Base, Target, HotFirstSorted<TTuple<Mappings...>, Ranks, GetKey>>;
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <FixedString.hpp>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace detail {
+
+// Keywords of one length share a group. A group's key is built from the bytes
+// at the discriminating positions first and second, or, when no pair of
+// positions tells its keywords apart, from the hash of the whole string.
+struct KeywordGroup {
+  uint32_t base = 0;
+  uint32_t mask = 0;
+  uint32_t seed = 0;
+  uint16_t first = 0;
+  uint16_t second = 0;
+  bool whole = false;
+};
+
+constexpr uint64_t KeywordKey(std::string_view word, const KeywordGroup& group) {
+  if (group.whole) {
+    return StringHash(word);
+  }
+  return uint8_t(word[group.first]) | uint64_t(uint8_t(word[group.second])) << 8;
+}
+
+constexpr uint32_t KeywordSlot(uint64_t key, const KeywordGroup& group) {
+  uint64_t mixed = (key ^ (group.seed * 0x9e3779b97f4a7c15ull)) * 0xff51afd7ed558ccdull;
+  return group.base + (uint32_t(mixed >> 32) & group.mask);
+}
+
+inline bool Equal16(const char* lhs, const char* rhs) {
+#ifdef __SSE2__
+  __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lhs)),
+                                 _mm_loadu_si128(reinterpret_cast<const __m128i*>(rhs)));
+  return _mm_movemask_epi8(equal) == 0xffff;
+#else
+  return std::memcmp(lhs, rhs, 16) == 0;
+#endif
+}
+
+}  // namespace detail
+
+// Compile-time set of keywords with find() returning the keyword's index.
+// A lookup dispatches on the length, hashes one or two bytes at positions
+// chosen at compile time to tell that length's keywords apart, and confirms
+// the single candidate with 16-byte vector compares against a zero-padded blob.
+template <FixedString... Keywords>
+struct StringSet {
+  static constexpr size_t Size = sizeof...(Keywords);
+
+  static std::optional<size_t> find(std::string_view word) {
+    // Lengths without keywords have an empty group (base 0), whose positions
+    // may lie outside word.
+    if (word.size() > kMaxLength || kGroups[word.size()].base == 0) {
+      return std::nullopt;
+    }
+    const detail::KeywordGroup& group = kGroups[word.size()];
+    size_t entry = kSlots[detail::KeywordSlot(detail::KeywordKey(word, group), group)];
+    if (entry == 0 || !Confirm(word, kBlob.data() + kOffsets[entry - 1])) {
+      return std::nullopt;
+    }
+    return entry - 1;
+  }
+
+  static constexpr std::string_view at(size_t index) {
+    return kWords[index];
+  }
+
+ private:
+  static constexpr std::array<std::string_view, Size> kWords = {std::string_view(Keywords)...};
+
+  static constexpr size_t kMaxLength = std::max({size_t(0), std::string_view(Keywords).size()...});
+  static constexpr uint32_t kMaxSeed = 1u << 12;
+
+  static consteval size_t Padded(size_t length) {
+    return std::max<size_t>(16, (length + 15) / 16 * 16);
+  }
+
+  static consteval bool Distinct(size_t length, size_t first, size_t second) {
+    for (size_t i = 0; i < Size; ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        if (kWords[i].size() == length && kWords[j].size() == length &&
+            kWords[i][first] == kWords[j][first] && kWords[i][second] == kWords[j][second]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static consteval bool Perfect(size_t length, const detail::KeywordGroup& group) {
+    for (size_t i = 0; i < Size; ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        if (kWords[i].size() == length && kWords[j].size() == length &&
+            detail::KeywordSlot(detail::KeywordKey(kWords[i], group), group) ==
+                detail::KeywordSlot(detail::KeywordKey(kWords[j], group), group)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static consteval bool Discriminate(size_t length, detail::KeywordGroup& group) {
+    for (size_t first = 0; first < length; ++first) {
+      for (size_t second = first; second < length; ++second) {
+        if (Distinct(length, first, second)) {
+          group.first = uint16_t(first);
+          group.second = uint16_t(second);
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  static consteval bool Unique() {
+    for (size_t i = 0; i < Size; ++i) {
+      for (size_t j = 0; j < i; ++j) {
+        if (kWords[i] == kWords[j]) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static consteval detail::KeywordGroup Group(size_t length, uint32_t base) {
+    detail::KeywordGroup group;
+    size_t count = std::ranges::count_if(kWords, [length](std::string_view word) { return word.size() == length; });
+    if (count == 0 || !Unique()) {
+      // Slot 0 stays empty, so unused lengths need no slots of their own.
+      return group;
+    }
+    group.base = base;
+    group.whole = !Discriminate(length, group);
+    for (uint32_t slots = std::bit_ceil(2 * count);; slots *= 2) {
+      group.mask = slots - 1;
+      for (group.seed = 0; group.seed < kMaxSeed; ++group.seed) {
+        if (Perfect(length, group)) {
+          return group;
+        }
+      }
+    }
+  }
+
+  static consteval std::array<detail::KeywordGroup, kMaxLength + 1> Groups() {
+    std::array<detail::KeywordGroup, kMaxLength + 1> groups{};
+    uint32_t base = 1;
+    for (size_t length = 0; length <= kMaxLength; ++length) {
+      groups[length] = Group(length, base);
+      if (groups[length].base != 0) {
+        base += groups[length].mask + 1;
+      }
+    }
+    return groups;
+  }
+
+  static constexpr std::array<detail::KeywordGroup, kMaxLength + 1> kGroups = Groups();
+
+  static consteval size_t SlotCount() {
+    size_t count = 1;
+    for (const detail::KeywordGroup& group : kGroups) {
+      if (group.base != 0) {
+        count = group.base + group.mask + 1;
+      }
+    }
+    return count;
+  }
+
+  static constexpr size_t kSlotCount = SlotCount();
+
+  static consteval std::array<uint16_t, kSlotCount> Slots() {
+    std::array<uint16_t, kSlotCount> slots{};
+    for (size_t i = 0; i < Size; ++i) {
+      const detail::KeywordGroup& group = kGroups[kWords[i].size()];
+      slots[detail::KeywordSlot(detail::KeywordKey(kWords[i], group), group)] = uint16_t(i + 1);
+    }
+    return slots;
+  }
+
+  static consteval std::array<uint32_t, Size> Offsets() {
+    std::array<uint32_t, Size> offsets{};
+    uint32_t offset = 0;
+    for (size_t i = 0; i < Size; ++i) {
+      offsets[i] = offset;
+      offset += Padded(kWords[i].size());
+    }
+    return offsets;
+  }
+
+  static constexpr std::array<uint32_t, Size> kOffsets = Offsets();
+  static constexpr size_t kBlobSize = (size_t(0) + ... + Padded(std::string_view(Keywords).size()));
+
+  static consteval std::array<char, kBlobSize> Blob() {
+    std::array<char, kBlobSize> blob{};
+    for (size_t i = 0; i < Size; ++i) {
+      std::ranges::copy(kWords[i], blob.begin() + kOffsets[i]);
+    }
+    return blob;
+  }
+
+  alignas(16) static constexpr std::array<char, kBlobSize> kBlob = Blob();
+  static constexpr std::array<uint16_t, kSlotCount> kSlots = Slots();
+
+  static_assert(Size < UINT16_MAX, "too many keywords");
+  static_assert(Unique(), "keywords must be distinct");
+
+  // keyword is zero-padded to a multiple of 16 bytes; the tail of word is
+  // copied into a zeroed buffer so that no load reads past its end.
+  static bool Confirm(std::string_view word, const char* keyword) {
+    size_t full = word.size() / 16 * 16;
+    for (size_t i = 0; i < full; i += 16) {
+      if (!detail::Equal16(word.data() + i, keyword + i)) {
+        return false;
+      }
+    }
+    if (full == word.size() && full != 0) {
+      return true;
+    }
+    char tail[16] = {};
+    if (word.size() != full) {
+      std::memcpy(tail, word.data() + full, word.size() - full);
+    }
+    return detail::Equal16(tail, keyword + full);
+  }
+};
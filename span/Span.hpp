@@ -1,3 +1,5 @@
+#pragma once
+
 #include <bits/iterator_concepts.h>
 #include <concepts>
 #include <cassert>
@@ -6,7 +8,8 @@
 #include <memory>
 #include <span>
 
-namespace {
+namespace detail {
+
 template <std::size_t Extent = std::dynamic_extent>
 class SpanStorage {
  public:
@@ -32,15 +35,16 @@ class SpanStorage<std::dynamic_extent> {
     extent_ = extent;
   }
 };
-}  // namespace
+
+}  // namespace detail
 
 template <class T, std::size_t Extent = std::dynamic_extent>
-class Span : SpanStorage<Extent> {
+class Span : detail::SpanStorage<Extent> {
  public:
   
   template <std::contiguous_iterator It>
   explicit(Extent != std::dynamic_extent) constexpr Span(It first, size_t count)
-      : SpanStorage<Extent>()
+      : detail::SpanStorage<Extent>()
       , data_(std::to_address(first)) {
     this->SetExtent(count);
   }
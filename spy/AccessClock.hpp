@@ -0,0 +1,37 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Time source of SiteProfiler and TraceRecorder: the TSC where there is one, steady_clock elsewhere.
+struct AccessClock {
+  static uint64_t Now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+  }
+
+  // Measured once, against steady_clock, on first use.
+  static double TicksPerNanosecond() {
+#if defined(__x86_64__) || defined(__i386__)
+    static const double ratio = [] {
+      auto start = std::chrono::steady_clock::now();
+      uint64_t ticks = Now();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      ticks = Now() - ticks;
+      std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+      return double(ticks) / elapsed.count();
+    }();
+    return ratio;
+#else
+    return 1.0;
+#endif
+  }
+};
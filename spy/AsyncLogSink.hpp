@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+struct SpyLogRecord {
+  uint64_t spy;
+  unsigned count;
+  std::chrono::steady_clock::time_point time;
+};
+
+enum class Backpressure {
+  // A full queue drops the record and counts it in dropped().
+  Drop,
+  // A full queue makes the accessing thread wait for the drainer.
+  Block,
+};
+
+// Moves the logger call off the accessing thread. The loggers it hands out
+// push an SpyLogRecord into a bounded lock-free multi-producer ring; a
+// background thread drains the ring in batches and calls logger(record) for
+// each record. Destroying the sink delivers every record pushed before it, so
+// the sink must outlive the Spys that log into it.
+template <std::invocable<const SpyLogRecord&> Logger>
+class AsyncLogSink {
+ public:
+  class SpyLogger {
+   public:
+    void operator()(unsigned count) const {
+      sink_->push({id_, count, std::chrono::steady_clock::now()});
+    }
+
+   private:
+    friend class AsyncLogSink;
+
+    SpyLogger(AsyncLogSink* sink, uint64_t id)
+      : sink_(sink)
+      , id_(id)
+    { }
+
+    AsyncLogSink* sink_;
+    uint64_t id_;
+  };
+
+  // capacity is rounded up to a power of two.
+  explicit AsyncLogSink(Logger logger, size_t capacity = 4096, Backpressure backpressure = Backpressure::Drop,
+                        std::chrono::microseconds idle = std::chrono::microseconds(500))
+    : logger_(std::move(logger))
+    , backpressure_(backpressure)
+    , idle_(idle)
+    , mask_(std::bit_ceil(std::max<size_t>(capacity, 2)) - 1)
+    , cells_(std::make_unique<Cell[]>(mask_ + 1))
+  {
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    drainer_ = std::thread([this] { Drain(); });
+  }
+
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  AsyncLogSink& operator=(const AsyncLogSink&) = delete;
+
+  ~AsyncLogSink() {
+    {
+      std::lock_guard lock(mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_one();
+    drainer_.join();
+  }
+
+  // Logger for Spy::setLogger; its records carry id.
+  SpyLogger logger(uint64_t id) {
+    return SpyLogger(this, id);
+  }
+
+  void push(const SpyLogRecord& record) {
+    while (!TryPush(record)) {
+      if (backpressure_ == Backpressure::Drop) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  // Waits until every record pushed before the call has been logged.
+  void flush() {
+    size_t target = tail_.load(std::memory_order_acquire);
+    wake_.notify_one();
+    while (logged_.load(std::memory_order_acquire) < target) {
+      std::this_thread::yield();
+    }
+  }
+
+  size_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr size_t kBatch = 256;
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    SpyLogRecord record;
+  };
+
+  // A cell is free for the push at position pos when its sequence equals pos,
+  // and holds that push's record when its sequence is pos + 1.
+  bool TryPush(const SpyLogRecord& record) {
+    size_t position = tail_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[position & mask_];
+      size_t sequence = cell.sequence.load(std::memory_order_acquire);
+      intptr_t difference = intptr_t(sequence) - intptr_t(position);
+      if (difference == 0) {
+        if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          cell.record = record;
+          cell.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = tail_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t PopBatch(SpyLogRecord* batch) {
+    size_t count = 0;
+    while (count < kBatch) {
+      Cell& cell = cells_[head_ & mask_];
+      if (cell.sequence.load(std::memory_order_acquire) != head_ + 1) {
+        break;
+      }
+      batch[count++] = cell.record;
+      cell.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+      ++head_;
+    }
+    return count;
+  }
+
+  void Drain() {
+    SpyLogRecord batch[kBatch];
+    for (;;) {
+      size_t count = PopBatch(batch);
+      for (size_t i = 0; i < count; ++i) {
+        logger_(batch[i]);
+      }
+      logged_.fetch_add(count, std::memory_order_release);
+      if (count != 0) {
+        continue;
+      }
+      std::unique_lock lock(mutex_);
+      // A push claims its position before writing the record, so stopping only
+      // once head_ has caught up with tail_ delivers every record pushed.
+      if (stopping_ && head_ == tail_.load(std::memory_order_acquire)) {
+        return;
+      }
+      wake_.wait_for(lock, idle_);
+    }
+  }
+
+  Logger logger_;
+  Backpressure backpressure_;
+  std::chrono::microseconds idle_;
+  size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<size_t> tail_{0};
+  alignas(64) size_t head_ = 0;
+  std::atomic<size_t> logged_{0};
+  alignas(64) std::atomic<size_t> dropped_{0};
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  std::thread drainer_;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <utility>
+
+// Passes one full-expression in about every `every` on to Logger. The gaps
+// between sampled expressions are drawn uniformly from [1, 2 * every - 1] with
+// an xorshift generator, so periodic access patterns do not alias with the
+// sampling, and each sampled count is multiplied by the gap it stands for,
+// which keeps the logged totals unbiased. An unsampled expression costs one
+// decrement and one branch.
+template <std::invocable<unsigned int> Logger>
+class SampledLogger {
+ public:
+  SampledLogger(Logger logger, uint32_t every, uint32_t seed = 0x9e3779b9)
+    : logger_(std::move(logger))
+    , every_(every == 0 ? 1 : every)
+    , state_(seed == 0 ? 1 : seed)
+  {
+    gap_ = countdown_ = NextGap();
+  }
+
+  void operator()(unsigned int count) {
+    if (--countdown_ != 0) [[likely]] {
+      return;
+    }
+    unsigned int scaled = count * gap_;
+    gap_ = countdown_ = NextGap();
+    logger_(scaled);
+  }
+
+  Logger& logger() {
+    return logger_;
+  }
+
+ private:
+  uint32_t NextGap() {
+    if (every_ == 1) {
+      return 1;
+    }
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 17;
+    state_ ^= state_ << 5;
+    return 1 + state_ % (2 * every_ - 1);
+  }
+
+  Logger logger_;
+  uint32_t every_;
+  uint32_t state_;
+  uint32_t countdown_;
+  uint32_t gap_;
+};
+
+// Calls Logger at most `burst` times in a row and `perSecond` times per second
+// on average (a token bucket). Counts of the expressions it holds back are
+// added to the next call that goes through, so totals stay exact. The clock is
+// only read when the bucket is empty, and then only every kClockStride
+// held-back expressions. perSecond must be positive; rates above one per
+// clock tick are treated as one per tick.
+template <std::invocable<unsigned int> Logger>
+class RateLimitedLogger {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr uint32_t kClockStride = 64;
+
+  RateLimitedLogger(Logger logger, double perSecond, uint32_t burst = 1)
+    : logger_(std::move(logger))
+    , interval_(Interval(perSecond))
+    , burst_(burst == 0 ? 1 : burst)
+    , tokens_(burst_)
+    , refilled_(Clock::now())
+  { }
+
+  void operator()(unsigned int count) {
+    pending_ += count;
+    if (tokens_ == 0 && (--countdown_ != 0 || !Refill())) [[likely]] {
+      return;
+    }
+    --tokens_;
+    unsigned int total = pending_;
+    pending_ = 0;
+    logger_(total);
+  }
+
+  // Counts held back so far, not yet passed to the logger.
+  unsigned int pending() const {
+    return pending_;
+  }
+
+  Logger& logger() {
+    return logger_;
+  }
+
+ private:
+  static Clock::duration Interval(double perSecond) {
+    assert(perSecond > 0 && "RateLimitedLogger needs a positive rate");
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / perSecond));
+    return std::max(interval, Clock::duration(1));
+  }
+
+  bool Refill() {
+    countdown_ = kClockStride;
+    Clock::time_point now = Clock::now();
+    auto earned = (now - refilled_) / interval_;
+    if (earned <= 0) {
+      return false;
+    }
+    tokens_ = earned >= burst_ ? burst_ : uint32_t(earned);
+    refilled_ = earned >= burst_ ? now : refilled_ + earned * interval_;
+    return true;
+  }
+
+  Logger logger_;
+  Clock::duration interval_;
+  uint32_t burst_;
+  uint32_t tokens_;
+  uint32_t countdown_ = 1;
+  unsigned int pending_ = 0;
+  Clock::time_point refilled_;
+};
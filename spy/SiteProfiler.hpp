@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <AccessClock.hpp>
+
+// Log-linear histogram of tick counts, HDR style: values below 8 have a bucket
+// each, larger ones are split into 8 buckets per power of two, so every bucket
+// is within 12.5% of the values it holds.
+class AccessHistogram {
+ public:
+  static constexpr size_t kSubBits = 3;
+  static constexpr size_t kSub = size_t(1) << kSubBits;
+  static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSub;
+
+  static constexpr size_t BucketOf(uint64_t value) {
+    if (value < kSub) {
+      return value;
+    }
+    size_t exponent = std::bit_width(value) - 1;
+    size_t sub = (value >> (exponent - kSubBits)) & (kSub - 1);
+    return (exponent - kSubBits + 1) * kSub + sub;
+  }
+
+  // Smallest value that falls into bucket.
+  static constexpr uint64_t LowerBound(size_t bucket) {
+    if (bucket < kSub) {
+      return bucket;
+    }
+    size_t exponent = bucket / kSub + kSubBits - 1;
+    return (kSub + bucket % kSub) << (exponent - kSubBits);
+  }
+
+  void Record(uint64_t ticks) {
+    counts_[BucketOf(ticks)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  std::array<uint64_t, kBuckets> Counts() const {
+    std::array<uint64_t, kBuckets> counts;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+  }
+
+  void Reset() {
+    for (std::atomic<uint64_t>& count : counts_) {
+      count.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, kBuckets> counts_{};
+};
+
+struct SiteSnapshot {
+  std::string_view file;
+  std::string_view function;
+  uint32_t line;
+  uint32_t column;
+  std::array<uint64_t, AccessHistogram::kBuckets> counts;
+
+  uint64_t Count() const {
+    uint64_t total = 0;
+    for (uint64_t count : counts) {
+      total += count;
+    }
+    return total;
+  }
+
+  // Lower bound, in ticks, of the bucket holding the q-th quantile.
+  uint64_t Quantile(double q) const {
+    uint64_t count = Count();
+    if (count == 0) {
+      return 0;
+    }
+    uint64_t rank = std::min(uint64_t(q * double(count)), count - 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+      seen += counts[i];
+      if (seen > rank) {
+        return AccessHistogram::LowerBound(i);
+      }
+    }
+    return 0;
+  }
+};
+
+// Per-call-site histograms of how long a Spy access is held, from operator->
+// to the end of the full-expression. Sites live in a fixed-size open-addressing
+// table claimed with compare-and-swap; a site's histogram is allocated by the
+// first access from it, so recording is lock-free and allocation-free after
+// warm-up. Accesses from sites that no longer fit are only counted in overflow().
+class SiteProfiler {
+ public:
+  explicit SiteProfiler(size_t capacity = 1024)
+    : mask_(std::bit_ceil(capacity) - 1)
+    , sites_(mask_ + 1)
+  { }
+
+  SiteProfiler(const SiteProfiler&) = delete;
+  SiteProfiler& operator=(const SiteProfiler&) = delete;
+
+  static SiteProfiler& Global() {
+    static SiteProfiler profiler;
+    return profiler;
+  }
+
+  AccessHistogram* Find(const std::source_location& location) {
+    uint64_t key = KeyOf(location);
+    for (size_t probe = 0; probe <= mask_; ++probe) {
+      Site& site = sites_[(key + probe) & mask_];
+      uint64_t current = site.key.load(std::memory_order_acquire);
+      if (current == 0 && site.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+        site.location = location;
+        site.histogram.store(new AccessHistogram, std::memory_order_release);
+        return site.histogram.load(std::memory_order_relaxed);
+      }
+      if (current == key) {
+        // The thread that claimed the site may still be allocating its histogram;
+        // its location is published with it.
+        AccessHistogram* histogram;
+        while ((histogram = site.histogram.load(std::memory_order_acquire)) == nullptr) {
+          std::this_thread::yield();
+        }
+        if (SameSite(site.location, location)) {
+          return histogram;
+        }
+      }
+    }
+    overflow_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  // Sites met so far, with a copy of their histograms; concurrent records may
+  // or may not be included.
+  std::vector<SiteSnapshot> Snapshot() const {
+    std::vector<SiteSnapshot> snapshot;
+    for (const Site& site : sites_) {
+      AccessHistogram* histogram = site.histogram.load(std::memory_order_acquire);
+      if (histogram != nullptr) {
+        snapshot.push_back({site.location.file_name(), site.location.function_name(), site.location.line(),
+                            site.location.column(), histogram->Counts()});
+      }
+    }
+    return snapshot;
+  }
+
+  // One line per site with its count and latency quantiles in nanoseconds.
+  void Dump(std::ostream& out) const {
+    double ticks = AccessClock::TicksPerNanosecond();
+    for (const SiteSnapshot& site : Snapshot()) {
+      out << site.file << ':' << site.line << ':' << site.column << " (" << site.function << "): " << site.Count()
+          << " accesses, p50 " << double(site.Quantile(0.5)) / ticks << " ns, p99 "
+          << double(site.Quantile(0.99)) / ticks << " ns, max " << double(site.Quantile(1.0)) / ticks << " ns\n";
+    }
+    if (size_t lost = overflow()) {
+      out << "overflow: " << lost << " accesses\n";
+    }
+  }
+
+  void Reset() {
+    for (Site& site : sites_) {
+      if (AccessHistogram* histogram = site.histogram.load(std::memory_order_acquire)) {
+        histogram->Reset();
+      }
+    }
+    overflow_.store(0, std::memory_order_relaxed);
+  }
+
+  size_t overflow() const {
+    return overflow_.load(std::memory_order_relaxed);
+  }
+
+  ~SiteProfiler() {
+    for (Site& site : sites_) {
+      delete site.histogram.load(std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  struct Site {
+    std::atomic<uint64_t> key{0};
+    std::atomic<AccessHistogram*> histogram{nullptr};
+    std::source_location location;
+  };
+
+  // Never 0, which marks free sites. The file is left out, since the same
+  // file may have a different file_name() pointer in every translation unit
+  // and hashing the name on every access would cost more than the lookup.
+  // Sites at the same line and column of different files share a key and are
+  // told apart by SameSite as the probe goes on.
+  static uint64_t KeyOf(const std::source_location& location) {
+    uint64_t key = uint64_t(location.line()) << 32 | location.column();
+    key *= 0x9e3779b97f4a7c15ull;
+    return (key ^ key >> 29) | 1;
+  }
+
+  static bool SameSite(const std::source_location& lhs, const std::source_location& rhs) {
+    return lhs.line() == rhs.line() && lhs.column() == rhs.column() &&
+           (lhs.file_name() == rhs.file_name() || std::string_view(lhs.file_name()) == rhs.file_name());
+  }
+
+  size_t mask_;
+  std::vector<Site> sites_;
+  std::atomic<size_t> overflow_{0};
+};
+
+// Result of Profiled(): forwards -> to the Spy's own operator-> (so the Spy
+// still counts and logs) and records the time it is held in its call site's
+// histogram when the full-expression ends.
+template <class Spy>
+class ProfiledPointer {
+ public:
+  using Pointer = decltype(std::declval<Spy&>().operator->());
+
+  ProfiledPointer(Spy& spy, AccessHistogram* histogram)
+    : start_(AccessClock::Now())
+    , histogram_(histogram)
+    , pointer_(spy.operator->())
+  { }
+
+  ProfiledPointer(const ProfiledPointer&) = delete;
+  ProfiledPointer& operator=(const ProfiledPointer&) = delete;
+
+  auto operator->() {
+    if constexpr (std::is_pointer_v<Pointer>) {
+      return pointer_;
+    } else {
+      return pointer_.operator->();
+    }
+  }
+
+  auto& operator*() {
+    return *pointer_;
+  }
+
+  ~ProfiledPointer() {
+    if (histogram_ != nullptr) {
+      histogram_->Record(AccessClock::Now() - start_);
+    }
+  }
+
+ private:
+  uint64_t start_;
+  AccessHistogram* histogram_;
+  Pointer pointer_;
+};
+
+// operator-> cannot take a source_location, so profiled accesses are written
+// Profiled(spy)->member instead of spy->member.
+template <class Spy>
+ProfiledPointer<Spy> Profiled(Spy& spy, SiteProfiler& profiler = SiteProfiler::Global(),
+                              std::source_location location = std::source_location::current()) {
+  return {spy, profiler.Find(location)};
+}
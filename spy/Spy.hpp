@@ -1,53 +1,160 @@
 #pragma once
 #include <bits/iterator_concepts.h>
+#include <array>
+#include <atomic>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 #include <concepts>
 #include <iostream>
 
 
-// Allocator is only used in bonus SBO tests,
-// ignore if you don't need bonus points.
+// Loggers that fit here and are nothrow-movable are stored inside the Spy;
+// larger ones go to the heap through the allocator given to setLogger.
+inline constexpr size_t kLoggerInlineSize = 4 * sizeof(void*);
+
+union LoggerStorage {
+  void* heap;
+  alignas(void*) std::byte buffer[kLoggerInlineSize];
+};
 
 struct LoggerVirtualTable {
-  typedef LoggerVirtualTable*(* TCopyFunction)(LoggerVirtualTable* from);
-  typedef void(* TDestroyFunction)(LoggerVirtualTable* ptr);
-  typedef void(* TLogFunction)(LoggerVirtualTable* logger);
+  typedef void(* TCopyFunction)(const LoggerStorage& from, LoggerStorage& to);
+  typedef void(* TMoveFunction)(LoggerStorage& from, LoggerStorage& to) noexcept;
+  typedef void(* TDestroyFunction)(LoggerStorage& logger) noexcept;
+  typedef void(* TLogFunction)(LoggerStorage& logger);
 
   TCopyFunction copy;
+  TMoveFunction move;
   TDestroyFunction destroy;
   TLogFunction initLog;
   TLogFunction endLog;
+  // Hands counts held back by the logger to it; nullptr if it holds none back.
+  TLogFunction flush = nullptr;
 
-  [[gnu::always_inline]] LoggerVirtualTable* Copy() {
-    return copy(this);
+  [[gnu::always_inline]] void Copy(const LoggerStorage& from, LoggerStorage& to) const {
+    copy(from, to);
+  }
+  [[gnu::always_inline]] void Move(LoggerStorage& from, LoggerStorage& to) const noexcept {
+    move(from, to);
+  }
+  [[gnu::always_inline]] void Destroy(LoggerStorage& logger) const noexcept {
+    destroy(logger);
   }
-  [[gnu::always_inline]] void Destroy() {
-    destroy(this);
+  [[gnu::always_inline]] void InitLog(LoggerStorage& logger) const {
+    initLog(logger);
   }
-  [[gnu::always_inline]] void InitLog() {
-    initLog(this);
+  [[gnu::always_inline]] void EndLog(LoggerStorage& logger) const {
+    endLog(logger);
   }
-  [[gnu::always_inline]] void EndLog() {
-    endLog(this);
+  void Flush(LoggerStorage& logger) const {
+    if (flush) {
+      flush(logger);
+    }
   }
 };
 
 
+// Loggers that also want to know when a full-expression starts accessing the
+// Spy define begin(), which is called on its first operator->.
+template <class Logger>
+concept BeginningLogger = requires(Logger& logger) { logger.begin(); };
+
+template <class Logger>
+[[gnu::always_inline]] inline void BeginExpression(Logger& logger, unsigned int counter) {
+  if constexpr (BeginningLogger<Logger>) {
+    if (counter == 0) {
+      logger.begin();
+    }
+  }
+}
+
 template <std::invocable<unsigned int> T>
-struct ErasedLogger : LoggerVirtualTable {
+struct ErasedLogger {
   T data;
   int counter = 0;
 
+  ErasedLogger(const ErasedLogger& other)
+    : data(other.data)
+    , counter(0){
+  }
+
+  ErasedLogger(ErasedLogger&& other) = default;
+
+  ErasedLogger(T logger)
+    : data(std::move(logger))
+  { }
+};
+
+template <class T, class Allocator>
+struct HeapLogger : ErasedLogger<T> {
+  [[no_unique_address]] Allocator allocator;
+
+  HeapLogger(T logger, const Allocator& alloc)
+    : ErasedLogger<T>(std::move(logger))
+    , allocator(alloc)
+  { }
+};
+
+template <class T, class Allocator>
+struct LoggerOperations {
+  static constexpr bool kInline = sizeof(ErasedLogger<T>) <= kLoggerInlineSize &&
+                                  alignof(ErasedLogger<T>) <= alignof(void*) &&
+                                  std::is_nothrow_move_constructible_v<T>;
+
+  using Stored = std::conditional_t<kInline, ErasedLogger<T>, HeapLogger<T, Allocator>>;
+  using Traits = typename std::allocator_traits<Allocator>::template rebind_traits<Stored>;
+
+  static Stored& Get(LoggerStorage& logger) {
+    if constexpr (kInline) {
+      return *std::launder(reinterpret_cast<Stored*>(logger.buffer));
+    } else {
+      return *static_cast<Stored*>(logger.heap);
+    }
+  }
+
+  static const Stored& Get(const LoggerStorage& logger) {
+    return Get(const_cast<LoggerStorage&>(logger));
+  }
+
+  template <class Object = Stored, class... Args>
+  static void Allocate(LoggerStorage& logger, const Allocator& allocator, Args&&... args) {
+    using ObjectTraits = typename std::allocator_traits<Allocator>::template rebind_traits<Object>;
+    typename ObjectTraits::allocator_type rebound(allocator);
+    Object* object = ObjectTraits::allocate(rebound, 1);
+    try {
+      ObjectTraits::construct(rebound, object, std::forward<Args>(args)...);
+    } catch (...) {
+      ObjectTraits::deallocate(rebound, object, 1);
+      throw;
+    }
+    logger.heap = object;
+  }
+
+  static void Create(LoggerStorage& logger, T data, const Allocator& allocator) {
+    if constexpr (kInline) {
+      ::new (logger.buffer) Stored(std::move(data));
+    } else {
+      Allocate(logger, allocator, std::move(data), allocator);
+    }
+  }
 
-  static LoggerVirtualTable* CopyFunction(LoggerVirtualTable* from) requires std::copyable<T> {
-    auto& object = *static_cast<ErasedLogger<T>*>(from);
-    auto copy = new ErasedLogger<T> (object);
-    return copy;
+  static void CopyFunction(const LoggerStorage& from, LoggerStorage& to) requires std::copyable<T> {
+    if constexpr (kInline) {
+      ::new (to.buffer) Stored(Get(from));
+    } else {
+      Allocator allocator = std::allocator_traits<Allocator>::select_on_container_copy_construction(Get(from).allocator);
+      Allocate(to, allocator, Get(from).data, allocator);
+    }
   }
-  consteval static TCopyFunction GetCopyFunction() {
+  consteval static LoggerVirtualTable::TCopyFunction GetCopyFunction() {
     if constexpr (std::copyable<T>) {
       return &CopyFunction;
     } else {
@@ -55,35 +162,325 @@ struct ErasedLogger : LoggerVirtualTable {
     }
   }
 
-  static void DestroyFunction(LoggerVirtualTable* ptr) {
-    delete static_cast<ErasedLogger<T>*>(ptr);
+  static void MoveFunction(LoggerStorage& from, LoggerStorage& to) noexcept {
+    if constexpr (kInline) {
+      ::new (to.buffer) Stored(std::move(Get(from)));
+      Get(from).~Stored();
+    } else {
+      to.heap = from.heap;
+    }
+  }
+
+  static void DestroyFunction(LoggerStorage& logger) noexcept {
+    if constexpr (kInline) {
+      Get(logger).~Stored();
+    } else {
+      Stored* stored = &Get(logger);
+      typename Traits::allocator_type allocator(stored->allocator);
+      Traits::destroy(allocator, stored);
+      Traits::deallocate(allocator, stored, 1);
+    }
   }
-  static void InitLogFunction(LoggerVirtualTable* logger) {
-    auto& object = *static_cast<ErasedLogger<T>*>(logger);
-    ++object.counter;
+
+  static void InitLogFunction(LoggerStorage& logger) {
+    BeginExpression(Get(logger).data, Get(logger).counter);
+    ++Get(logger).counter;
   }
-  static void EndLogFunction(LoggerVirtualTable* logger) {
-    auto& object = *static_cast<ErasedLogger<T>*>(logger);
+  static void EndLogFunction(LoggerStorage& logger) {
+    auto& object = Get(logger);
     if(object.counter != 0) {
       object.data(object.counter);
       object.counter = 0;
     }
   }
 
-  ErasedLogger(const ErasedLogger& other)
-    : LoggerVirtualTable(other)
-    , data(other.data)
-    , counter(0){
+  static constexpr LoggerVirtualTable kTable{
+    .copy = GetCopyFunction(), .move = &MoveFunction, .destroy = &DestroyFunction,
+    .initLog = &InitLogFunction, .endLog = &EndLogFunction};
+};
+
+template <class T, class Allocator>
+struct SharedLogger : HeapLogger<T, Allocator> {
+  size_t references = 1;
+
+  using HeapLogger<T, Allocator>::HeapLogger;
+};
+
+// Copies share one heap logger and its counter through an intrusive,
+// non-atomic reference count: copying is a pointer copy and an increment.
+template <class T, class Allocator>
+struct SharedLoggerOperations {
+  using Stored = SharedLogger<T, Allocator>;
+  using Traits = typename std::allocator_traits<Allocator>::template rebind_traits<Stored>;
+
+  static Stored& Get(const LoggerStorage& logger) {
+    return *static_cast<Stored*>(logger.heap);
+  }
+
+  static void Create(LoggerStorage& logger, T data, const Allocator& allocator) {
+    LoggerOperations<T, Allocator>::template Allocate<Stored>(logger, allocator, std::move(data), allocator);
+  }
+
+  static void CopyFunction(const LoggerStorage& from, LoggerStorage& to) {
+    ++Get(from).references;
+    to.heap = from.heap;
+  }
+
+  static void MoveFunction(LoggerStorage& from, LoggerStorage& to) noexcept {
+    to.heap = from.heap;
+  }
+
+  static void DestroyFunction(LoggerStorage& logger) noexcept {
+    Stored* stored = &Get(logger);
+    if (--stored->references != 0) {
+      return;
+    }
+    typename Traits::allocator_type allocator(stored->allocator);
+    Traits::destroy(allocator, stored);
+    Traits::deallocate(allocator, stored, 1);
+  }
+
+  static void InitLogFunction(LoggerStorage& logger) {
+    BeginExpression(Get(logger).data, Get(logger).counter);
+    ++Get(logger).counter;
   }
+  static void EndLogFunction(LoggerStorage& logger) {
+    auto& object = Get(logger);
+    if(object.counter != 0) {
+      object.data(object.counter);
+      object.counter = 0;
+    }
+  }
+
+  static constexpr LoggerVirtualTable kTable{
+    .copy = &CopyFunction, .move = &MoveFunction, .destroy = &DestroyFunction,
+    .initLog = &InitLogFunction, .endLog = &EndLogFunction};
+};
+
+// Accesses counted by this thread in the full-expressions it is evaluating,
+// one entry per logger. Entries only live from the first operator-> to the end
+// of the expression, so they never outlive the loggers they point to.
+struct ThreadAccessCounts {
+  static constexpr size_t kCapacity = 8;
+
+  const void* owners[kCapacity];
+  unsigned counts[kCapacity];
+  size_t size = 0;
+
+  // Returns nullptr when the thread already counts for kCapacity loggers.
+  unsigned* Find(const void* owner, bool insert) {
+    for (size_t i = 0; i < size; ++i) {
+      if (owners[i] == owner) {
+        return &counts[i];
+      }
+    }
+    if (!insert || size == kCapacity) {
+      return nullptr;
+    }
+    owners[size] = owner;
+    counts[size] = 0;
+    return &counts[size++];
+  }
+
+  void Erase(unsigned* count) {
+    size_t i = count - counts;
+    --size;
+    owners[i] = owners[size];
+    counts[i] = counts[size];
+  }
+
+  static ThreadAccessCounts& Local() {
+    thread_local ThreadAccessCounts counts;
+    return counts;
+  }
+};
+
+// Full-expressions a thread merges into one call of a concurrent logger,
+// unless setConcurrentLogger is given another count.
+inline constexpr uint32_t kConcurrentFlushEvery = 64;
+
+// Counts the finished expressions of one thread have left for one concurrent
+// logger, on a cache line of its own. Only the owning thread adds to it, so
+// the additions never contend; a flush from another thread takes the
+// accesses with an exchange.
+struct alignas(64) ConcurrentPending {
+  std::thread::id owner;
+  std::atomic<uint64_t> accesses{0};
+  // Touched by the owning thread only.
+  uint32_t expressions = 0;
+};
+
+// Each thread's ConcurrentPending of the concurrent loggers it uses, direct-
+// mapped by logger id. Loggers are told apart by id rather than address, so a
+// logger created where a destroyed one lived never picks up a stale entry.
+struct ConcurrentPendingCache {
+  static constexpr size_t kSlots = 8;
+
+  struct Slot {
+    uint64_t logger = 0;
+    ConcurrentPending* pending = nullptr;
+  };
+
+  static Slot& Local(uint64_t logger) {
+    thread_local std::array<Slot, kSlots> slots;
+    return slots[logger % kSlots];
+  }
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> loggers{0};
+    return loggers.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+};
+
+template <class T, class Allocator>
+struct ConcurrentLogger {
+  T data;
+  uint32_t flushEvery;
+  [[no_unique_address]] Allocator allocator;
+  uint64_t id = ConcurrentPendingCache::NextId();
+  // Guards calls of data and the list of threads.
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ConcurrentPending>> threads;
 
-  ErasedLogger<T>(T logger)
-    : LoggerVirtualTable{.copy = GetCopyFunction(), .destroy=&DestroyFunction, .initLog=&InitLogFunction, .endLog=&EndLogFunction}
-    , data(std::move(logger))
+  ConcurrentLogger(T logger, uint32_t every, const Allocator& alloc)
+    : data(std::move(logger))
+    , flushEvery(every == 0 ? 1 : every)
+    , allocator(alloc)
   { }
+
+  // The calling thread's counts; the mutex is only taken on a cache miss.
+  ConcurrentPending& Local() {
+    ConcurrentPendingCache::Slot& slot = ConcurrentPendingCache::Local(id);
+    if (slot.logger != id) [[unlikely]] {
+      slot.pending = &Register();
+      slot.logger = id;
+    }
+    return *slot.pending;
+  }
+
+  ConcurrentPending& Register() {
+    std::lock_guard lock(mutex);
+    std::thread::id self = std::this_thread::get_id();
+    for (std::unique_ptr<ConcurrentPending>& pending : threads) {
+      if (pending->owner == self) {
+        return *pending;
+      }
+    }
+    threads.push_back(std::make_unique<ConcurrentPending>());
+    threads.back()->owner = self;
+    return *threads.back();
+  }
+
+  void Deliver(uint64_t accesses) {
+    if (accesses != 0) {
+      std::lock_guard lock(mutex);
+      data(static_cast<unsigned>(accesses));
+    }
+  }
+
+  void FlushAll() {
+    std::lock_guard lock(mutex);
+    uint64_t accesses = 0;
+    for (std::unique_ptr<ConcurrentPending>& pending : threads) {
+      accesses += pending->accesses.exchange(0, std::memory_order_relaxed);
+    }
+    if (accesses != 0) {
+      data(static_cast<unsigned>(accesses));
+    }
+  }
+};
+
+// Loggers for a Spy accessed from several threads at once. Accesses are
+// counted per thread and per full-expression in thread-local storage; a
+// finished expression adds its count to its thread's own ConcurrentPending,
+// which the thread hands to the logger, under a mutex, once flushEvery
+// expressions have accumulated there. Whatever is left is delivered by flushLogger and when
+// the logger is destroyed.
+template <class T, class Allocator>
+struct ConcurrentLoggerOperations {
+  using Stored = ConcurrentLogger<T, Allocator>;
+  using Traits = typename std::allocator_traits<Allocator>::template rebind_traits<Stored>;
+
+  static Stored& Get(const LoggerStorage& logger) {
+    return *static_cast<Stored*>(logger.heap);
+  }
+
+  static void Create(LoggerStorage& logger, T data, uint32_t flushEvery, const Allocator& allocator) {
+    LoggerOperations<T, Allocator>::template Allocate<Stored>(logger, allocator, std::move(data),
+                                                              flushEvery, allocator);
+  }
+
+  static void CopyFunction(const LoggerStorage& from, LoggerStorage& to) requires std::copyable<T> {
+    const Stored& other = Get(from);
+    Allocator allocator = std::allocator_traits<Allocator>::select_on_container_copy_construction(other.allocator);
+    Create(to, other.data, other.flushEvery, allocator);
+  }
+  consteval static LoggerVirtualTable::TCopyFunction GetCopyFunction() {
+    if constexpr (std::copyable<T>) {
+      return &CopyFunction;
+    } else {
+      return nullptr;
+    }
+  }
+
+  static void MoveFunction(LoggerStorage& from, LoggerStorage& to) noexcept {
+    to.heap = from.heap;
+  }
+
+  static void DestroyFunction(LoggerStorage& logger) noexcept {
+    Stored* stored = &Get(logger);
+    stored->FlushAll();
+    typename Traits::allocator_type allocator(stored->allocator);
+    Traits::destroy(allocator, stored);
+    Traits::deallocate(allocator, stored, 1);
+  }
+
+  static void InitLogFunction(LoggerStorage& logger) {
+    if (unsigned* count = ThreadAccessCounts::Local().Find(logger.heap, true)) {
+      ++*count;
+    } else {
+      Get(logger).Local().accesses.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  static void EndLogFunction(LoggerStorage& logger) {
+    ThreadAccessCounts& counts = ThreadAccessCounts::Local();
+    unsigned* count = counts.Find(logger.heap, false);
+    if (count == nullptr) {
+      return;
+    }
+    unsigned accesses = *count;
+    counts.Erase(count);
+    Stored& object = Get(logger);
+    ConcurrentPending& pending = object.Local();
+    pending.accesses.fetch_add(accesses, std::memory_order_relaxed);
+    if (++pending.expressions >= object.flushEvery) [[unlikely]] {
+      pending.expressions = 0;
+      object.Deliver(pending.accesses.exchange(0, std::memory_order_relaxed));
+    }
+  }
+
+  static void FlushFunction(LoggerStorage& logger) {
+    Get(logger).FlushAll();
+  }
+
+  static constexpr LoggerVirtualTable kTable{
+    .copy = GetCopyFunction(), .move = &MoveFunction, .destroy = &DestroyFunction,
+    .initLog = &InitLogFunction, .endLog = &EndLogFunction, .flush = &FlushFunction};
+};
+
+// Logger of the statically bound Spy<T, NullLogger>, which does not count at all.
+struct NullLogger {
+  void operator()(unsigned int) const noexcept {}
 };
 
+// Spy<T> erases the type of its logger, which can be changed at run time;
+// Spy<T, Logger> stores a Logger by value and calls it directly.
+template <class T, class Logger = void>
+class Spy;
+
 template <class T>
-class Spy {
+class Spy<T, void> {
 public:
   explicit Spy(T val) : value_{std::move(val)} {}
 
@@ -97,7 +494,8 @@ public:
 
   struct ImplicitPointer {
     T* ptr;
-    LoggerVirtualTable* vt;
+    const LoggerVirtualTable* vt;
+    LoggerStorage* logger;
     T& operator*() {
       return *ptr;
     }
@@ -106,26 +504,27 @@ public:
     }
     ~ImplicitPointer() {
       if(vt){
-        vt->EndLog();
+        vt->EndLog(*logger);
       }
     }
   };
 
   ImplicitPointer operator ->() {
-    if(logger_) logger_->InitLog();
-    return {&value_, logger_};
+    if(vtable_) vtable_->InitLog(logger_);
+    return {&value_, vtable_, &logger_};
   }
 
   Spy() requires std::default_initializable<T> = default;
 
-  bool operator==(const Spy<T>& other) const requires std::regular<T> {
+  bool operator==(const Spy& other) const requires std::regular<T> {
     return value_ == other.value_;
   }
 
   Spy(const Spy& other) requires std::copyable<T>
     : value_(other.value_)
-    , logger_(other.logger_?other.logger_->Copy():nullptr)
-  {}
+  {
+    copyLogger(other);
+  }
 
   Spy& operator=(const Spy& other) requires std::copyable<T> {
     if (this == &other) {
@@ -133,15 +532,14 @@ public:
     }
     value_ = other.value_;
     resetLogger();
-    logger_ = other.logger_ ? other.logger_->Copy(): nullptr;
+    copyLogger(other);
     return *this;
   }
 
   Spy(Spy&& other) noexcept(std::is_nothrow_move_constructible_v<T>) requires std::movable<T> 
     : value_(std::move(other.value_))
-    , logger_(other.logger_)
   {
-    other.logger_ = nullptr;
+    moveLogger(other);
   }
 
   Spy& operator=(Spy&& other) noexcept(std::is_nothrow_move_assignable_v<T>) requires std::movable<T> {
@@ -150,8 +548,7 @@ public:
     }
     value_ = std::move(other.value_);
     resetLogger();
-    logger_ = other.logger_;
-    other.logger_ = nullptr;
+    moveLogger(other);
     return *this;
   }
   /*
@@ -165,26 +562,221 @@ public:
 
   // Resets logger
   void resetLogger() {
-    if (logger_ == nullptr) {
+    if (vtable_ == nullptr) {
       return;
     }
-    logger_->Destroy();
-    logger_ = nullptr;
+    vtable_->Destroy(logger_);
+    vtable_ = nullptr;
   }
   
-  template <std::invocable<unsigned int> Logger> requires 
+  template <std::invocable<unsigned int> Logger, class Allocator = std::allocator<std::byte>> requires 
     (std::is_nothrow_destructible_v<std::remove_reference_t<Logger>> || !std::is_nothrow_destructible_v<T>) &&
     (std::copyable<std::remove_reference_t<Logger>> || (!std::copyable<T>))
-  void setLogger(Logger&& logger) {
+  void setLogger(Logger&& logger, const Allocator& allocator = Allocator()) {
+    using Operations = LoggerOperations<std::remove_cvref_t<Logger>, Allocator>;
+    resetLogger();
+    Operations::Create(logger_, std::forward<Logger>(logger), allocator);
+    vtable_ = &Operations::kTable;
+  }
+
+  // Like setLogger, but copies of this Spy share the logger and its access
+  // counter instead of cloning them, so the logger need not be copyable.
+  template <std::invocable<unsigned int> Logger, class Allocator = std::allocator<std::byte>> requires
+    (std::is_nothrow_destructible_v<std::remove_reference_t<Logger>> || !std::is_nothrow_destructible_v<T>)
+  void setSharedLogger(Logger&& logger, const Allocator& allocator = Allocator()) {
+    using Operations = SharedLoggerOperations<std::remove_cvref_t<Logger>, Allocator>;
+    resetLogger();
+    Operations::Create(logger_, std::forward<Logger>(logger), allocator);
+    vtable_ = &Operations::kTable;
+  }
+
+  // Like setLogger, but the Spy may be accessed from several threads at once.
+  // The logger is called under a lock, with the accesses of flushEvery
+  // full-expressions of a thread merged into one call. Those calls no longer
+  // match single expressions, so loggers that define begin() are rejected.
+  template <std::invocable<unsigned int> Logger, class Allocator = std::allocator<std::byte>> requires
+    (std::is_nothrow_destructible_v<std::remove_reference_t<Logger>> || !std::is_nothrow_destructible_v<T>) &&
+    (std::copyable<std::remove_reference_t<Logger>> || (!std::copyable<T>)) &&
+    (!BeginningLogger<std::remove_cvref_t<Logger>>)
+  void setConcurrentLogger(Logger&& logger, uint32_t flushEvery = kConcurrentFlushEvery,
+                           const Allocator& allocator = Allocator()) {
+    using Operations = ConcurrentLoggerOperations<std::remove_cvref_t<Logger>, Allocator>;
     resetLogger();
-    logger_ = new ErasedLogger<std::remove_reference_t<Logger>>(std::forward<Logger>(logger));
+    Operations::Create(logger_, std::forward<Logger>(logger), flushEvery, allocator);
+    vtable_ = &Operations::kTable;
+  }
+
+  // Hands the counts a concurrent logger has held back to it.
+  void flushLogger() {
+    if (vtable_) {
+      vtable_->Flush(logger_);
+    }
   }
 
   ~Spy() noexcept(std::is_nothrow_destructible_v<T>){
-    if(logger_) logger_->Destroy();
+    resetLogger();
+  }
+
+private:
+  void copyLogger(const Spy& other) {
+    if (other.vtable_) {
+      other.vtable_->Copy(other.logger_, logger_);
+      vtable_ = other.vtable_;
+    }
+  }
+
+  void moveLogger(Spy& other) noexcept {
+    if (other.vtable_) {
+      other.vtable_->Move(other.logger_, logger_);
+      vtable_ = other.vtable_;
+      other.vtable_ = nullptr;
+    }
+  }
+
+  T value_;
+  const LoggerVirtualTable* vtable_ = nullptr;
+  LoggerStorage logger_;
+};
+
+template <class T, std::invocable<unsigned int> Logger>
+class Spy<T, Logger> {
+public:
+  explicit Spy(T val) requires std::default_initializable<Logger>
+    : value_{std::move(val)}
+  {}
+
+  Spy(T val, Logger logger)
+    : value_{std::move(val)}
+    , logger_{std::move(logger)}
+  {}
+
+  T& operator *() {
+    return value_;
+  }
+  const T& operator *() const {
+    return value_;
+  }
+
+  struct ImplicitPointer {
+    T* ptr;
+    Spy* spy;
+    T& operator*() {
+      return *ptr;
+    }
+    T* operator->() {
+      return ptr;
+    }
+    ~ImplicitPointer() {
+      if (spy->counter_ != 0) {
+        spy->logger_(spy->counter_);
+        spy->counter_ = 0;
+      }
+    }
+  };
+
+  ImplicitPointer operator ->() {
+    BeginExpression(logger_, counter_);
+    ++counter_;
+    return {&value_, this};
+  }
+
+  Spy() requires std::default_initializable<T> && std::default_initializable<Logger> = default;
+
+  bool operator==(const Spy& other) const requires std::regular<T> {
+    return value_ == other.value_;
+  }
+
+  Spy(const Spy& other) requires std::copyable<T> && std::copy_constructible<Logger>
+    : value_(other.value_)
+    , logger_(other.logger_)
+  {}
+
+  // Loggers that cannot be assigned (lambdas with captures) are rebuilt in
+  // place instead, which keeps Spy<T, Logger> copyable whenever T is and
+  // Logger is copy-constructible. It is regular only if Logger is also
+  // default-initializable.
+  Spy& operator=(const Spy& other) requires std::copyable<T> &&
+    (std::is_copy_assignable_v<Logger> || std::is_nothrow_copy_constructible_v<Logger>) {
+    if (this == &other) {
+      return *this;
+    }
+    value_ = other.value_;
+    if constexpr (std::is_copy_assignable_v<Logger>) {
+      logger_ = other.logger_;
+    } else {
+      std::destroy_at(&logger_);
+      std::construct_at(&logger_, other.logger_);
+    }
+    return *this;
+  }
+
+  Spy(Spy&& other) noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_constructible_v<Logger>)
+    requires std::movable<T> && std::move_constructible<Logger>
+    : value_(std::move(other.value_))
+    , logger_(std::move(other.logger_))
+  {}
+
+  Spy& operator=(Spy&& other) noexcept(std::is_nothrow_move_assignable_v<T> &&
+    (std::is_nothrow_move_assignable_v<Logger> || !std::is_move_assignable_v<Logger>)) requires std::movable<T> &&
+    (std::is_move_assignable_v<Logger> || std::is_nothrow_move_constructible_v<Logger>) {
+    if (this == &other) {
+      return *this;
+    }
+    value_ = std::move(other.value_);
+    if constexpr (std::is_move_assignable_v<Logger>) {
+      logger_ = std::move(other.logger_);
+    } else {
+      std::destroy_at(&logger_);
+      std::construct_at(&logger_, std::move(other.logger_));
+    }
+    return *this;
+  }
+
+  Logger& logger() {
+    return logger_;
+  }
+
+private:
+  T value_;
+  Logger logger_;
+  unsigned int counter_ = 0;
+};
+
+// Nothing to log: operator-> is a plain pointer to the value and a
+// Spy<T, NullLogger> has the size and layout of T.
+template <class T>
+class Spy<T, NullLogger> {
+public:
+  explicit Spy(T val) : value_{std::move(val)} {}
+
+  Spy(T val, NullLogger) : value_{std::move(val)} {}
+
+  Spy() requires std::default_initializable<T> = default;
+
+  T& operator *() {
+    return value_;
+  }
+  const T& operator *() const {
+    return value_;
+  }
+
+  T* operator ->() {
+    return &value_;
+  }
+  const T* operator ->() const {
+    return &value_;
+  }
+
+  bool operator==(const Spy& other) const requires std::regular<T> {
+    return value_ == other.value_;
   }
 
 private:
   T value_;
-  LoggerVirtualTable *logger_ = nullptr;
-};
\ No newline at end of file
+};
+
+template <class T>
+Spy(T) -> Spy<T>;
+
+template <class T, std::invocable<unsigned int> Logger>
+Spy(T, Logger) -> Spy<T, Logger>;
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <AccessClock.hpp>
+
+struct TraceEvent {
+  uint64_t time;
+  uint64_t object;
+  // 'B' when a full-expression starts accessing the object, 'E' when it ends.
+  char phase;
+};
+
+// Records when Spys are accessed, for viewing on a timeline. Every thread
+// writes to its own preallocated buffer, found through a thread_local cache
+// with a slot per recorder, so recording neither locks nor allocates once the
+// thread has recorded once, even when it alternates between recorders.
+// Events that do not fit are counted in dropped(). Export can run while
+// threads record; it sees every event published before it reads a buffer.
+class TraceRecorder {
+ public:
+  // Logger for Spy::setLogger (or Spy<T, TraceRecorder::SpyLogger>): a 'B'
+  // event on the first access of every full-expression, an 'E' event at its end.
+  class SpyLogger {
+   public:
+    void begin() {
+      recorder_->Record('B', object_);
+    }
+
+    void operator()(unsigned int) {
+      recorder_->Record('E', object_);
+    }
+
+   private:
+    friend class TraceRecorder;
+
+    SpyLogger(TraceRecorder* recorder, uint64_t object)
+      : recorder_(recorder)
+      , object_(object)
+    { }
+
+    TraceRecorder* recorder_;
+    uint64_t object_;
+  };
+
+  explicit TraceRecorder(size_t eventsPerThread = size_t(1) << 16)
+    : capacity_(eventsPerThread)
+    , id_(NextRecorderId())
+  { }
+
+  TraceRecorder(const TraceRecorder&) = delete;
+  TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+  SpyLogger logger(uint64_t object) {
+    return SpyLogger(this, object);
+  }
+
+  void Record(char phase, uint64_t object) {
+    ThreadBuffer& buffer = Local();
+    size_t size = buffer.size.load(std::memory_order_relaxed);
+    if (size == capacity_) [[unlikely]] {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    buffer.events[size] = {AccessClock::Now(), object, phase};
+    buffer.size.store(size + 1, std::memory_order_release);
+  }
+
+  // Chrome Trace Event Format, loadable in chrome://tracing and Perfetto.
+  // Threads are numbered in the order they first recorded.
+  void ExportChromeTrace(std::ostream& out) const {
+    double ticks = AccessClock::TicksPerNanosecond();
+    std::lock_guard lock(mutex_);
+    uint64_t origin = UINT64_MAX;
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers_) {
+      if (buffer->size.load(std::memory_order_acquire) != 0) {
+        origin = std::min(origin, buffer->events[0].time);
+      }
+    }
+    out << "{\"traceEvents\":[";
+    const char* separator = "\n";
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers_) {
+      size_t size = buffer->size.load(std::memory_order_acquire);
+      for (size_t i = 0; i < size; ++i) {
+        const TraceEvent& event = buffer->events[i];
+        out << separator << "{\"name\":\"spy " << event.object << "\",\"cat\":\"spy\",\"ph\":\"" << event.phase
+            << "\",\"ts\":" << double(event.time - origin) / ticks / 1000.0 << ",\"pid\":1,\"tid\":"
+            << buffer->thread << '}';
+        separator = ",\n";
+      }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+  }
+
+  size_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+  // Must not run concurrently with Record.
+  void Clear() {
+    std::lock_guard lock(mutex_);
+    for (std::unique_ptr<ThreadBuffer>& buffer : buffers_) {
+      buffer->size.store(0, std::memory_order_relaxed);
+    }
+    dropped_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  struct ThreadBuffer {
+    std::thread::id owner;
+    size_t thread;
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<size_t> size{0};
+  };
+
+  struct LocalCache {
+    uint64_t recorder = 0;
+    ThreadBuffer* buffer = nullptr;
+  };
+
+  // Recorders with consecutive ids get different slots, so up to this many
+  // recorders in use on one thread never evict each other.
+  static constexpr size_t kLocalCacheSlots = 8;
+
+  static uint64_t NextRecorderId() {
+    static std::atomic<uint64_t> recorders{0};
+    return recorders.fetch_add(1, std::memory_order_relaxed) + 1;
+  }
+
+  // Recorders are told apart by id rather than address, so a recorder created
+  // where a destroyed one lived never picks up its stale cache entry. The
+  // cache is direct-mapped by id: a hit is one compare, and only a miss takes
+  // the mutex in Register.
+  ThreadBuffer& Local() {
+    thread_local std::array<LocalCache, kLocalCacheSlots> cache;
+    LocalCache& slot = cache[id_ % kLocalCacheSlots];
+    if (slot.recorder != id_) [[unlikely]] {
+      slot.buffer = &Register();
+      slot.recorder = id_;
+    }
+    return *slot.buffer;
+  }
+
+  ThreadBuffer& Register() {
+    std::lock_guard lock(mutex_);
+    std::thread::id self = std::this_thread::get_id();
+    for (std::unique_ptr<ThreadBuffer>& buffer : buffers_) {
+      if (buffer->owner == self) {
+        return *buffer;
+      }
+    }
+    buffers_.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer& buffer = *buffers_.back();
+    buffer.owner = self;
+    buffer.thread = buffers_.size();
+    buffer.events = std::make_unique<TraceEvent[]>(capacity_);
+    return buffer;
+  }
+
+  size_t capacity_;
+  uint64_t id_;
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  std::atomic<size_t> dropped_{0};
+};